@@ -12,6 +12,11 @@ void TestConnectionMain();
 void TestKeyMain();
 void TestScriptMain();
 void TestPoolMain();
+void TestPipelineMain();
+void TestParserMain();
+void TestNumericMain();
+void TestCacheMain();
+void TestMultiplexerMain();
 
 void TranSactionMain();
 
@@ -86,3 +91,28 @@ TEST_F(CTestRedis, TestPoolMain)
 {
     //TestPoolMain();
 }
+
+TEST_F(CTestRedis, TestPipelineMain)
+{
+    TestPipelineMain();
+}
+
+TEST_F(CTestRedis, TestParserMain)
+{
+    TestParserMain();
+}
+
+TEST_F(CTestRedis, TestNumericMain)
+{
+    TestNumericMain();
+}
+
+TEST_F(CTestRedis, TestCacheMain)
+{
+    TestCacheMain();
+}
+
+TEST_F(CTestRedis, TestMultiplexerMain)
+{
+    TestMultiplexerMain();
+}
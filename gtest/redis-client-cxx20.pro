@@ -0,0 +1,13 @@
+# The same tests built with C++20: CRedisCoroutine.h is only usable then, so the co_await test
+# of testMultiplexer.cpp is compiled and run by this target only.
+# qmake redis-client-cxx20.pro && make && ./redis-client-cxx20		(g++ 10 or later)
+
+include( redis-client.pro )
+
+TARGET = redis-client-cxx20
+
+CONFIG -= c++11 c++14 c++1z
+CONFIG += c++2a
+# a qmake older than 5.12 does not know c++2a.
+QMAKE_CXXFLAGS += -std=c++2a
+*g++*: QMAKE_CXXFLAGS += -fcoroutines
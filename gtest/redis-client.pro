@@ -15,11 +15,23 @@ INCLUDEPATH += \
 
 HEADERS += \
     ../redis-client/Command.h \
+    ../redis-client/CmdHeader.h \
     ../redis-client/CRedisClient.h \
     ../redis-client/CRedisPool.h \
     ../redis-client/CRedisSocket.h \
     ../redis-client/CResult.h \
     ../redis-client/RdException.hpp \
+    ../redis-client/CRedisEventLoop.h \
+    ../redis-client/CRedisCoroutine.h \
+    ../redis-client/CRedisMultiplexer.h \
+    ../redis-client/CRedisUringTransport.h \
+    ../redis-client/CRedisTransport.h \
+    ../redis-client/CRedisCache.h \
+    ../redis-client/CRedisParser.h \
+    ../redis-client/CStringsHandler.h \
+    ../redis-client/CRedisTransaction.h \
+    ../redis-client/CRedisPipeline.h \
+    ../redis-client/RdNumeric.h \
     ../redis-client/redisCommon.h \
     CTestRedis.h
 
@@ -30,6 +42,11 @@ SOURCES += \
     testKey.cpp \
     testList.cpp \
     testPool.cpp \
+    testPipeline.cpp \
+    testParser.cpp \
+    testNumeric.cpp \
+    testCache.cpp \
+    testMultiplexer.cpp \
     testPSub.cpp \
     testscript.cpp \
     testServer.cpp \
@@ -54,6 +71,15 @@ SOURCES += \
     ../redis-client/RedisClientSortedSet.cpp \
     ../redis-client/RedisClientString.cpp \
     ../redis-client/RedisTransaction.cpp \
+    ../redis-client/CRedisEventLoop.cpp \
+    ../redis-client/CRedisMultiplexer.cpp \
+    ../redis-client/CRedisUringTransport.cpp \
+    ../redis-client/CRedisTransport.cpp \
+    ../redis-client/CRedisCache.cpp \
+    ../redis-client/CRedisParser.cpp \
+    ../redis-client/CRedisTransaction.cpp \
+    ../redis-client/CRedisPipeline.cpp \
+    ../redis-client/RdNumeric.cpp \
     CTestRedis.cpp
 
 
@@ -0,0 +1,90 @@
+/**
+ * @file	testCache.cpp
+ * @brief 测试 CRedisCache 客户端缓存模块
+ *
+ */
+
+#include <iostream>
+#include <unistd.h>
+#include "CRedisClient.h"
+#include "CRedisCache.h"
+#include "RdException.hpp"
+#include "CResult.h"
+
+using namespace std;
+
+static void _printStats( const CRedisCache& cache )
+{
+    CRedisCache::Stats stats = cache.getStats();
+    std::cout << "hits: " << stats.hits << ", misses: " << stats.misses
+              << ", evictions: " << stats.evictions << ", invalidations: " << stats.invalidations
+              << ", size: " << stats.size << std::endl;
+}
+
+void TestCacheMain( void )
+{
+    try
+    {
+        CRedisClient writer;
+        writer.connect( "127.0.0.1", 6379 );
+        writer.set( "testCache", "v1" );
+
+        //------------------------test invalidations through listen()-----------
+        CRedisCache cache( 1000 );
+        cache.listen( "127.0.0.1", 6379 );
+
+        CRedisClient redis;
+        redis.connect( "127.0.0.1", 6379 );
+        redis.enableCache( &cache );
+
+        string value;
+        for ( int i = 0; i < 1000; ++i )
+        {
+            redis.get( "testCache", value );
+        }
+        std::cout << "value: " << value << std::endl;
+        _printStats( cache );
+
+        writer.set( "testCache", "v2" );
+        usleep( 100 * 1000 );
+        redis.get( "testCache", value );
+        std::cout << "value after set: " << value << std::endl;
+        _printStats( cache );
+
+        //------------------------test listen() again---------------------------
+        // the connection redirects its invalidations to the new listener.
+        cache.listen( "127.0.0.1", 6379 );
+        redis.get( "testCache", value );
+        writer.set( "testCache", "v2 again" );
+        usleep( 100 * 1000 );
+        redis.get( "testCache", value );
+        std::cout << "value after listen again: " << value << std::endl;
+        _printStats( cache );
+        redis.enableCache( NULL );
+
+        //------------------------test invalidations pushed with RESP3----------
+        CRedisCache cache3( 1000 );
+        CResult result;
+        redis.hello( result );
+        redis.enableCache( &cache3 );
+        redis.get( "testCache", value );
+        writer.set( "testCache", "v3" );
+        usleep( 100 * 1000 );
+        redis.get( "testCache", value );
+        std::cout << "value after set: " << value << std::endl;
+        _printStats( cache3 );
+
+        // only invalidations are taken by the cache, the pushed replies of unsubscribe are not.
+        redis.unsubscribe( result );
+        std::cout << "unsubscribe: " << result << std::endl;
+        redis.get( "testCache", value );
+        std::cout << "value after unsubscribe: " << value << std::endl;
+        redis.enableCache( NULL );
+    }catch( RdException& e )
+    {
+        std::cout << "Redis exception:" << e.what() << std::endl;
+    }catch( Poco::Exception& e )
+    {
+        std::cout << "Poco_exception:" << e.what() << std::endl;
+    }
+}
@@ -15,6 +15,11 @@
 #include <sstream>
 #include "RdException.hpp"
 #include "CResult.h"
+#include "CRedisUringTransport.h"
+#include <chrono>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <Poco/Thread.h>
 
 using namespace std;
 
@@ -105,6 +110,218 @@ void TestSelect( void )
 	}
 }
 
+void TestConnectUnix( void )
+{
+	try
+	{
+		CRedisClient redis;
+		// unixsocket /tmp/redis.sock in redis.conf
+		redis.setTimeout( 1, 0 );
+		redis.connect( "/tmp/redis.sock" );
+
+		string value;
+		redis.ping( value );
+		redis.reconnect();
+		redis.ping( value );
+		std::cout << redis.getAddr() << ": " << value << std::endl;
+	} catch( RdException& e )
+	{
+		std::cout << "Redis exception:" << e.what() << std::endl;
+	}
+}
+
+void TestConnectUring( void )
+{
+	try
+	{
+		CRedisClient redis;
+		redis.setTransport( CRedisTransport::TRANSPORT_IO_URING );
+		redis.connect( "127.0.0.1", 6379 );
+
+		string value;
+		redis.ping( value );
+		std::cout << ( CRedisTransport::TRANSPORT_IO_URING == redis.getTransport() ? "io_uring: " : "posix: " )
+				  << value << std::endl;
+	} catch( RdException& e )
+	{
+		std::cout << "Redis exception:" << e.what() << std::endl;
+	}
+}
+
+#ifdef CREDIS_HAVE_IO_URING
+///< the other end of a socketpair, it plays redis.
+struct UringStub
+{
+	int fd;
+	size_t requestBytes;	///< read before replying.
+	string reply;
+};
+
+static void _onUringStub( void* pVoid )
+{
+	UringStub* pStub = static_cast<UringStub*>( pVoid );
+	char buf[4096];
+	for ( size_t got = 0; got < pStub->requestBytes; )
+	{
+		ssize_t n = ::read( pStub->fd, buf, std::min( sizeof( buf ), pStub->requestBytes - got ) );
+		if ( n <= 0 )
+		{
+			return;
+		}
+		got += n;
+	}
+	for ( size_t sent = 0; sent < pStub->reply.size(); )
+	{
+		ssize_t n = ::write( pStub->fd, pStub->reply.data() + sent, pStub->reply.size() - sent );
+		if ( n <= 0 )
+		{
+			return;
+		}
+		sent += n;
+	}
+}
+
+/**
+ * @brief _uringPair attach transport to one end of a socketpair.
+ * @return the other end.
+ */
+static int _uringPair( CRedisUringTransport& transport )
+{
+	int sv[2];
+	if ( ::socketpair( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv ) < 0 )
+	{
+		throw ConnectErr( "socketpair failed" );
+	}
+	transport.attach( sv[0] );
+	return sv[1];
+}
+
+static string _receiveAll( CRedisTransport& transport, size_t len )
+{
+	string data( len, '\0' );
+	size_t got = 0;
+	while ( got < len )
+	{
+		size_t n = transport.receive( &data[got], len - got );
+		if ( 0 == n )
+		{
+			break;
+		}
+		got += n;
+	}
+	data.resize( got );
+	return data;
+}
+
+static int64_t _elapsedMs( const std::chrono::steady_clock::time_point& start )
+{
+	return std::chrono::duration_cast<std::chrono::milliseconds>( std::chrono::steady_clock::now() - start ).count();
+}
+
+void TestConnectUringStub( void )
+{
+	if ( !CRedisUringTransport::supported() )
+	{
+		std::cout << "io_uring is not supported by this kernel" << std::endl;
+		return;
+	}
+	try
+	{
+		CRedisUringTransport transport;
+		int peer = _uringPair( transport );
+		transport.setReceiveTimeout( Timespan( 2, 0 ) );
+		transport.setSendTimeout( Timespan( 2, 0 ) );
+		UringStub stub;
+		stub.fd = peer;
+		Poco::Thread thread;
+
+		//------------------------test a reply larger than all the provided buffers------
+		// the recv is armed by the first reply, the big one fills every buffer while nobody
+		// reads: the recv ends with ENOBUFS and must be armed again.
+		stub.requestBytes = 0;
+		stub.reply = "+OK\r\n";
+		_onUringStub( &stub );
+		std::cout << "first reply: " << _receiveAll( transport, 5 ).size() << std::endl;
+		size_t size = 256 * 1024;
+		stub.reply = "$" + std::to_string( size ) + "\r\n" + string( size, 'x' ) + "\r\n";
+		thread.start( _onUringStub, &stub );
+		Poco::Thread::sleep( 100 );
+		string data = _receiveAll( transport, stub.reply.size() );
+		thread.join();
+		std::cout << "large reply: " << data.size() << " bytes, same: " << ( data == stub.reply ) << std::endl;
+
+		//------------------------test a pipelined burst------------------------
+		Command ping( "PING" );
+		string request;
+		for ( int i = 0; i < 1000; ++i )
+		{
+			request += string( ping );
+		}
+		stub.requestBytes = request.size();
+		stub.reply.clear();
+		for ( int i = 0; i < 1000; ++i )
+		{
+			stub.reply += "+PONG\r\n";
+		}
+		thread.start( _onUringStub, &stub );
+		for ( size_t sent = 0; sent < request.size(); )
+		{
+			sent += transport.send( request.data() + sent, request.size() - sent );
+		}
+		data = _receiveAll( transport, stub.reply.size() );
+		thread.join();
+		std::cout << "pipelined replies: " << data.size() / 7 << ", same: " << ( data == stub.reply ) << std::endl;
+
+		//------------------------test the receive timeout-----------------------
+		transport.setReceiveTimeout( Timespan( 0, 100 * 1000 ) );
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		try
+		{
+			char ch;
+			transport.receive( &ch, 1 );
+			std::cout << "receive: no timeout!" << std::endl;
+		}catch( ConnectErr& e )
+		{
+			std::cout << "receive: " << e.what() << " after " << _elapsedMs( start ) << " ms" << std::endl;
+		}
+
+		//------------------------test the send timeout, the sendmsg is cancelled-------
+		int small = 4096;
+		::setsockopt( transport.fd(), SOL_SOCKET, SO_SNDBUF, &small, sizeof( small ) );
+		::setsockopt( peer, SOL_SOCKET, SO_RCVBUF, &small, sizeof( small ) );
+		transport.setSendTimeout( Timespan( 0, 100 * 1000 ) );
+		string big( 4 * 1024 * 1024, 'x' );
+		start = std::chrono::steady_clock::now();
+		try
+		{
+			size_t sent = transport.send( big.data(), big.size() );
+			std::cout << "send: " << sent << " of " << big.size() << " bytes";
+		}catch( ConnectErr& e )
+		{
+			std::cout << "send: " << e.what();
+		}
+		std::cout << " after " << _elapsedMs( start ) << " ms" << std::endl;
+		transport.close();
+		::close( peer );
+
+		//------------------------test the peer closing--------------------------
+		peer = _uringPair( transport );
+		transport.setReceiveTimeout( Timespan( 2, 0 ) );
+		stub.fd = peer;
+		stub.requestBytes = 0;
+		stub.reply = "+OK\r\n";
+		_onUringStub( &stub );
+		::close( peer );
+		data = _receiveAll( transport, 64 );
+		char ch;
+		std::cout << "before eof: " << data.size() << " bytes, then: " << transport.receive( &ch, 1 ) << std::endl;
+	} catch( RdException& e )
+	{
+		std::cout << "Redis exception:" << e.what() << std::endl;
+	}
+}
+#endif
+
 void TestConnectionMain( void )
 {
 //	TestPing();
@@ -112,6 +329,11 @@ void TestConnectionMain( void )
 //	TestEcho();
 //	TestAuth();
 //	TestSelect();
+//	TestConnectUnix();
+//	TestConnectUring();
+#ifdef CREDIS_HAVE_IO_URING
+	TestConnectUringStub();
+#endif
     return;
 }
 
@@ -307,6 +307,49 @@ void TestLrange( void )
 	}
 }
 
+class CPrintHandler : public CRedisReplyHandler
+{
+public:
+	CPrintHandler( size_t stopAt ):
+		_count( 0 ),
+		_stopAt( stopAt )
+	{
+	}
+
+	bool onBulk( const char* data, size_t len )
+	{
+		cout << string( data, len ) << endl;
+		return ++_count < _stopAt;
+	}
+
+	size_t _count;
+	size_t _stopAt;
+};
+
+void TestLrangeHandler( void )
+{
+	try
+	{
+		CRedisClient redis;
+		redis.connect("127.0.0.1", 6379);
+
+		CPrintHandler handler( 3 );
+		bool complete = redis.lrange("testList", 0, -1, handler);
+		std::cout << "complete: " << complete << ", count: " << handler._count << std::endl;
+
+		redis.setMaxRecvSize( CRedisClient::MAX_RECV_SIZE );
+		CRedisClient::VecString value;
+		uint64_t count = redis.lrange("testList", 0, -1, value);
+		std::cout << count << std::endl;
+	} catch( RdException& e )
+	{
+		std::cout << "Redis exception:" << e.what() << std::endl;
+	} catch( Poco::Exception& e )
+	{
+		std::cout << "Poco_exception:" << e.what() << std::endl;
+	}
+}
+
 void TestRpoplpush( )
 {
 	try
@@ -462,6 +505,7 @@ void TestListMain( void )
 //  TestLtrim();
 //  TestLset();
 //  TestLrange();
+//  TestLrangeHandler();
 //  TestRpoplpush();
 //  TestBlpop();
 //  TestBrpop();
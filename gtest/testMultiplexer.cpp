@@ -0,0 +1,165 @@
+/**
+ * @file	testMultiplexer.cpp
+ * @brief 测试 CRedisMultiplexer 多路复用连接
+ *
+ */
+
+#include <iostream>
+#include <vector>
+#include <Poco/Thread.h>
+#include <Poco/Event.h>
+#include <Poco/AtomicCounter.h>
+#include "CRedisMultiplexer.h"
+#include "CRedisCoroutine.h"
+#include "RdException.hpp"
+#include "CResult.h"
+
+using namespace std;
+
+static void _printStats( const CRedisMultiplexer& mux )
+{
+    CRedisMultiplexer::Stats stats = mux.getStats();
+    std::cout << "commands: " << stats.commands << ", writes: " << stats.writes
+              << ", reconnects: " << stats.reconnects << std::endl;
+}
+
+static void _onWork( void* pVoid )
+{
+    CRedisMultiplexer* pMux = static_cast<CRedisMultiplexer*>( pVoid );
+    string value;
+    for ( int i = 0; i < 1000; ++i )
+    {
+        pMux->set( "testMultiplexer", "value" );
+        pMux->get( "testMultiplexer", value );
+    }
+}
+
+#ifdef CREDIS_HAVE_COROUTINE
+///< starts at once, nobody waits for it.
+struct DetachedTask
+{
+    struct promise_type
+    {
+        DetachedTask get_return_object() { return DetachedTask(); }
+        std::suspend_never initial_suspend() { return std::suspend_never(); }
+        std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+        void return_void() {}
+        void unhandled_exception() {}
+    };
+};
+
+static DetachedTask _coWork( CRedisCoClient& redis, Poco::Event& done )
+{
+    try
+    {
+        string value;
+        co_await redis.set( "testCoroutine", "value" );
+        bool exist = co_await redis.get( "testCoroutine", value );
+        std::cout << "co_await get: " << exist << " " << value << std::endl;
+        std::cout << "co_await del: " << co_await redis.del( "testCoroutine" ) << std::endl;
+    }catch( RdException& e )
+    {
+        std::cout << "Redis exception:" << e.what() << std::endl;
+    }
+    done.set();
+}
+#endif
+
+void TestMultiplexerMain( void )
+{
+    try
+    {
+        CRedisMultiplexer mux;
+        mux.connect( "127.0.0.1", 6379 );
+
+        //------------------------test commands from many threads---------------
+        std::vector<Poco::Thread*> threads;
+        for ( int i = 0; i < 8; ++i )
+        {
+            threads.push_back( new Poco::Thread );
+            threads.back()->start( _onWork, &mux );
+        }
+        for ( size_t i = 0; i < threads.size(); ++i )
+        {
+            threads[i]->join();
+            delete threads[i];
+        }
+        _printStats( mux );
+
+        //------------------------test send with callbacks----------------------
+        Poco::Event done;
+        Poco::AtomicCounter count( 100 );
+        for ( int i = 0; i < 100; ++i )
+        {
+            Command cmd( "GET" );
+            cmd << "testMultiplexer";
+            mux.send( cmd, [&done, &count]( CResult& reply, const std::exception_ptr& error )
+            {
+                if ( error || reply != "value" )
+                {
+                    std::cout << "send: unexpected reply!" << std::endl;
+                }
+                if ( 0 == --count )
+                {
+                    done.set();
+                }
+            } );
+        }
+        done.wait();
+
+        //------------------------test futures----------------------------------
+        std::future<uint8_t> hset = mux.hsetAsync( "testMultiplexerHash", "field", "value" );
+        std::future<CRedisMultiplexer::Value> get = mux.getAsync( "testMultiplexer" );
+        std::future<CRedisMultiplexer::Value> hget = mux.hgetAsync( "testMultiplexerHash", "field" );
+        std::cout << "hset: " << ( int )hset.get() << std::endl;
+        CRedisMultiplexer::Value value = get.get();
+        std::cout << "get: " << value.exists << " " << value.value << std::endl;
+        value = hget.get();
+        std::cout << "hget: " << value.exists << " " << value.value << std::endl;
+        std::cout << "del: " << mux.delAsync( "testMultiplexerHash" ).get() << std::endl;
+        std::cout << "del: " << mux.del( "testMultiplexer" ) << std::endl;
+        _printStats( mux );
+
+        //------------------------test connections sharing one loop-------------
+        CRedisEventLoop loop;
+        loop.start();
+        std::vector<CRedisMultiplexer*> shards;
+        for ( int i = 0; i < 16; ++i )
+        {
+            shards.push_back( new CRedisMultiplexer( &loop ) );
+            shards.back()->setTimeout( 1, 0 );
+            shards.back()->connect( "127.0.0.1", 6379 );
+        }
+        std::vector< std::future<void> > sets;
+        for ( size_t i = 0; i < shards.size(); ++i )
+        {
+            sets.push_back( shards[i]->setAsync( "testMultiplexerShard", "value" ) );
+        }
+        for ( size_t i = 0; i < sets.size(); ++i )
+        {
+            sets[i].get();
+        }
+        for ( size_t i = 0; i < shards.size(); ++i )
+        {
+            shards[i]->close();
+            delete shards[i];
+        }
+        std::cout << "del: " << mux.del( "testMultiplexerShard" ) << std::endl;
+
+#ifdef CREDIS_HAVE_COROUTINE
+        //------------------------test co_await---------------------------------
+        CRedisCoClient coRedis( mux );
+        Poco::Event coDone;
+        _coWork( coRedis, coDone );
+        coDone.wait();
+#else
+        std::cout << "co_await is not tested, build redis-client-cxx20.pro" << std::endl;
+#endif
+    }catch( RdException& e )
+    {
+        std::cout << "Redis exception:" << e.what() << std::endl;
+    }catch( Poco::Exception& e )
+    {
+        std::cout << "Poco_exception:" << e.what() << std::endl;
+    }
+}
@@ -0,0 +1,58 @@
+/**
+ * @file	testNumeric.cpp
+ * @brief 测试 RdNumeric 模块在非 "C" locale 下的数值转换，不需要 redis 服务器。
+ *
+ */
+
+#include <iostream>
+#include <locale.h>
+#include "RdNumeric.h"
+#include "Command.h"
+#include "CResult.h"
+
+using namespace std;
+
+void TestNumericMain( void )
+{
+    // a program may call setlocale(), redis still writes and reads "1.5".
+    const char* old = setlocale( LC_ALL, NULL );
+    string oldLocale = old ? old : "C";
+    const char* names[] = { "de_DE.UTF-8", "de_DE.utf8", "de_DE" };
+    const char* locale = NULL;
+    for ( size_t i = 0; i < sizeof( names ) / sizeof( names[0] ) && NULL == locale; ++i )
+    {
+        locale = setlocale( LC_ALL, names[i] );
+    }
+    if ( NULL == locale )
+    {
+        std::cout << "locale de_DE is not installed, tested in the current locale" << std::endl;
+    }else
+    {
+        std::cout << "locale: " << locale << ", decimal point: " << localeconv()->decimal_point << std::endl;
+    }
+
+    char buf[RdNumeric::MAX_DOUBLE_SIZE];
+    size_t len = RdNumeric::formatDouble( 1.5, buf );
+    std::cout << "formatDouble( 1.5 ): " << string( buf, len ) << std::endl;
+    len = RdNumeric::formatFloat( 0.25f, buf );
+    std::cout << "formatFloat( 0.25 ): " << string( buf, len ) << std::endl;
+
+    double dbl = 0;
+    bool ok = RdNumeric::parseDouble( "3.14", 4, dbl );
+    std::cout << "parseDouble( 3.14 ): " << ok << " " << ( 3.14 == dbl ) << std::endl;
+    ok = RdNumeric::parseDouble( "3,14", 4, dbl );
+    std::cout << "parseDouble( 3,14 ): " << ok << std::endl;
+    float flt = 0;
+    ok = RdNumeric::parseFloat( "-0.5", 4, flt );
+    std::cout << "parseFloat( -0.5 ): " << ok << " " << ( -0.5f == flt ) << std::endl;
+
+    Command cmd( "ZINCRBY" );
+    cmd << "key" << 2.5 << "member";
+    std::cout << "command has $3\\r\\n2.5: " << ( string::npos != string( cmd ).find( "$3\r\n2.5\r\n" ) ) << std::endl;
+
+    CResult result( string( "0.125" ) );
+    result.setType( REDIS_REPLY_DOUBLE );
+    std::cout << "CResult getDouble(): " << ( 0.125 == result.getDouble() ) << std::endl;
+
+    setlocale( LC_ALL, oldLocale.c_str() );
+}
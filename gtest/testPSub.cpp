@@ -11,6 +11,8 @@
 #include "CRedisClient.h"
 #include <stdio.h>
 #include <sstream>
+#include <unistd.h>
+#include <Poco/Thread.h>
 #include "RdException.hpp"
 #include "CResult.h"
 
@@ -115,6 +117,64 @@ void TestUNSUBSCRIBE( CRedisClient& redis )
 
 
 
+///< thrown by the push callback to leave subscribe().
+struct StopSubscribe
+{
+};
+
+
+static void _onPublish( void* )
+{
+	usleep( 100 * 1000 );
+	CRedisClient redis;
+	redis.connect( "127.0.0.1", 6379 );
+	redis.publish( "msg", "good morning" );
+}
+
+
+void TestPUSHCALLBACK( void )
+{
+	std::cout << "------testPUSH CALLBACK------" << std::endl;
+	// with RESP3 the replies of subscribe and unsubscribe are pushed too, they must not be
+	// taken by the callback. Messages are, the connection still serves other commands.
+	CRedisClient redis;
+	redis.connect( "127.0.0.1", 6379 );
+	CResult result;
+	redis.hello( result );
+	redis.setPushCallback( []( CResult& push )
+	{
+		std::cout << "push: " << push << std::endl;
+		if ( "message" == push.getArry()[0] )
+		{
+			throw StopSubscribe();
+		}
+	} );
+
+	Poco::Thread publisher;
+	publisher.start( _onPublish, NULL );
+	CRedisClient::VecString channel;
+	channel.push_back("msg");
+	channel.push_back("chat_room");
+	try
+	{
+		redis.subscribe( channel, result );
+	}catch( StopSubscribe& )
+	{
+		std::cout << "subscribe stopped by the message" << std::endl;
+	}
+	publisher.join();
+
+	redis.unsubscribe( result, CRedisClient::VecString( 1, "msg" ) );
+	std::cout << "unsubscribe msg: " << result << std::endl;
+	redis.unsubscribe( result );
+	std::cout << "unsubscribe: " << result << std::endl;
+	string value;
+	redis.ping( value );
+	std::cout << "ping: " << value << std::endl;
+}
+
+
+
 void TestPSubMain( void )
 {
     try
@@ -136,6 +196,7 @@ void TestPSubMain( void )
         TestPUNSUBSCRIBE( redis );
         //TestSUBSCRIBE( redis );
         TestUNSUBSCRIBE( redis );
+        TestPUSHCALLBACK();
 
 
     }catch( RdException& e )
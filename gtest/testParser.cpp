@@ -0,0 +1,136 @@
+/**
+ * @file	testParser.cpp
+ * @brief 测试 CRedisParser 模块，不需要 redis 服务器。
+ *
+ */
+
+#include <iostream>
+#include <sys/time.h>
+#include "CRedisParser.h"
+#include "RdException.hpp"
+#include "CResult.h"
+#include "CStringsHandler.h"
+
+using namespace std;
+
+static double _nowMs( void )
+{
+    struct timeval tv;
+    gettimeofday( &tv, NULL );
+    return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+/**
+ * @brief _parseInPieces feed data to the parser piece bytes at a time.
+ * @return bytes consumed by the reply.
+ */
+static size_t _parseInPieces( CRedisParser& parser, CResult& result, const string& data, size_t piece )
+{
+    parser.reset( result );
+    size_t pos = 0;
+    while ( pos < data.size() )
+    {
+        size_t consumed = 0;
+        size_t len = std::min( piece, data.size() - pos );
+        CRedisParser::Status status = parser.feed( data.data() + pos, len, consumed );
+        pos += consumed;
+        if ( CRedisParser::COMPLETE == status )
+        {
+            return pos;
+        }
+    }
+    std::cout << "reply is not complete" << std::endl;
+    return pos;
+}
+
+void TestParserMain( void )
+{
+    try
+    {
+        CRedisParser parser;
+        CResult result;
+
+        //------------------------test one byte at a time------------------------
+        string data = "*5\r\n:12\r\n+OK\r\n-ERR wrong\r\n$5\r\nhello\r\n*2\r\n$-1\r\n*0\r\n";
+        size_t consumed = _parseInPieces( parser, result, data, 1 );
+        std::cout << "consumed: " << consumed << "/" << data.size() << std::endl;
+        std::cout << result << std::endl;
+
+        //------------------------test two replies in one piece------------------
+        data = "$3\r\nfoo\r\n:1\r\n";
+        consumed = _parseInPieces( parser, result, data, data.size() );
+        std::cout << "first: " << result << ", consumed: " << consumed << std::endl;
+        consumed = _parseInPieces( parser, result, data.substr( consumed ), data.size() );
+        std::cout << "second: " << result << ", consumed: " << consumed << std::endl;
+
+        //------------------------test deep nesting, no recursion----------------
+        data.clear();
+        for ( int i = 0; i < 1000; ++i )
+        {
+            data += "*1\r\n";
+        }
+        data += ":1\r\n";
+        _parseInPieces( parser, result, data, 7 );
+        std::cout << "nested depth 1000 parsed" << std::endl;
+
+        //------------------------test RESP3 types, 3 bytes at a time-------------
+        data = "|1\r\n+ttl\r\n:3600\r\n%3\r\n+score\r\n,1.5\r\n+flag\r\n#f\r\n"
+               "+members\r\n~3\r\n(12345678901234567890\r\n=9\r\ntxt:hello\r\n_\r\n";
+        _parseInPieces( parser, result, data, 3 );
+        std::cout << result << std::endl;
+        std::cout << "attribute: " << parser.attribute() << std::endl;
+        std::cout << "score: " << result.getArry()[1].getDouble() << ", flag: "
+                  << result.getArry()[3].getBool() << ", verbatim: "
+                  << result.getArry()[5].getArry()[1].getVerbatim() << std::endl;
+
+        //------------------------test RESP3 pairs streamed to CStringsHandler----
+        // ZRANGE ... WITHSCORES replies an array of [member, score] arrays in RESP3.
+        data = "*2\r\n*2\r\n$1\r\na\r\n,1.5\r\n*2\r\n$1\r\nb\r\n,2\r\n";
+        CStringsHandler::TupleString pairs;
+        CStringsHandler handler( NULL, &pairs );
+        parser.reset( handler );
+        consumed = 0;
+        parser.feed( data.data(), data.size(), consumed );
+        std::cout << "pairs: " << pairs.size() << ", count: " << handler.getCount() << std::endl;
+        for ( size_t i = 0; i < pairs.size(); ++i )
+        {
+            std::cout << std::get<0>( pairs[i] ) << ": " << std::get<1>( pairs[i] ) << std::endl;
+        }
+
+        data = "*1\r\n*2\r\n$1\r\na\r\n,1.5\r\n";
+        pairs.clear();
+        CStringsHandler one( NULL, &pairs );
+        parser.reset( one );
+        parser.feed( data.data(), data.size(), consumed );
+        std::cout << "one pair: " << pairs.size() << ", " << ( pairs.empty() ? "" : std::get<0>( pairs[0] ) )
+                  << ": " << ( pairs.empty() ? "" : std::get<1>( pairs[0] ) ) << std::endl;
+
+        //------------------------test invalid data------------------------------
+        try
+        {
+            _parseInPieces( parser, result, "$abc\r\n", 64 );
+        }catch( ProtocolErr& e )
+        {
+            std::cout << "ProtocolErr: " << e.what() << std::endl;
+        }
+
+        //------------------------benchmark--------------------------------------
+        data = "*1000\r\n";
+        for ( int i = 0; i < 1000; ++i )
+        {
+            data += "$10\r\n0123456789\r\n";
+        }
+        int loops = 1000;
+        double start = _nowMs();
+        for ( int i = 0; i < loops; ++i )
+        {
+            _parseInPieces( parser, result, data, 16 * 1024 );
+        }
+        double used = _nowMs() - start;
+        std::cout << "parse " << loops << " arrays of 1000 elements: " << used << " ms, "
+                  << data.size() * loops / 1024.0 / 1024.0 / ( used / 1000.0 ) << " MB/s" << std::endl;
+    }catch( RdException& e )
+    {
+        std::cout << "Redis exception:" << e.what() << std::endl;
+    }
+}
@@ -0,0 +1,63 @@
+/**
+ * @file	testPipeline.cpp
+ * @brief 测试 Pipeline 模块
+ *
+ */
+
+#include <iostream>
+#include "Command.h"
+#include "CRedisClient.h"
+#include "CRedisPipeline.h"
+#include "RdException.hpp"
+#include "CResult.h"
+
+using namespace std;
+
+void TestPipelineMain( void )
+{
+    try
+    {
+        CRedisClient redis;
+        redis.connect( "127.0.0.1", 6379 );
+
+        //------------------------test add, exec---------------------------------
+        CRedisPipeline pipe( redis );
+        for ( int i = 0; i < 1000; ++i )
+        {
+            pipe.add( CMD_HSET ) << "testPipeline" << i << "value";
+        }
+        pipe.add( CMD_HLEN ) << "testPipeline";
+        pipe.add( "NOSUCHCOMMAND" );
+
+        Command cmd( CMD_HGET );
+        cmd << "testPipeline" << 10;
+        size_t index = pipe.add( cmd );
+
+        CRedisPipeline::VecResult results;
+        size_t errNum = pipe.exec( results );
+        std::cout << "results: " << results.size() << ", errors: " << errNum << std::endl;
+        std::cout << "hlen: " << results[1000] << std::endl;
+        std::cout << "error: " << results[1001] << std::endl;
+        std::cout << "hget: " << results[index] << std::endl;
+
+        //------------------------test pipeline of a pool handle-----------------
+        CRedisPool pool;
+        pool.init( "127.0.0.1", 6379, "", 0, 2 );
+        CRedisPipeline poolPipe( pool.getRedis( 1000 ) );
+        poolPipe.add( CMD_INCR ) << "testPipelineCounter";
+        poolPipe.add( CMD_INCR ) << "testPipelineCounter";
+        poolPipe.exec( results );
+        std::cout << "incr: " << results[0] << results[1] << std::endl;
+
+        CRedisClient::VecString keys;
+        keys.push_back( "testPipeline" );
+        keys.push_back( "testPipelineCounter" );
+        redis.del( keys );
+    }catch( RdException& e )
+    {
+        std::cout << "Redis exception:" << e.what() << std::endl;
+    }catch( Poco::Exception& e )
+    {
+        std::cout << "Poco_exception:" << e.what() << std::endl;
+    }
+}
@@ -95,6 +95,20 @@ void TestGET( CRedisClient& redis )
 	std::cout << "value:" << value << std::endl;
 }
 
+void TestGETVIEW( CRedisClient& redis )
+{
+	std::cout << "------testGETVIEW------" << std::endl;
+	redis.set("db", std::string(100000, 'r'));
+	uint64_t pieces = 0, total = 0;
+	bool bRet = redis.getView("db", [&]( const CRedisClient::ReplyView& view )
+	{
+		++pieces;
+		total += view.len;
+	});
+	std::cout << "bRet: " << bRet << std::endl;
+	std::cout << "pieces: " << pieces << ", length: " << total << std::endl;
+}
+
 
 void TestGETBIT( CRedisClient& redis )
 {
@@ -326,6 +340,7 @@ void TestStringMain( void )
 	TestDECR( redis );
 	TestDECRBY( redis );
 	TestGET( redis );
+	TestGETVIEW( redis );
 	TestGETBIT( redis );
 	TestGETRANGE( redis );
 	TestGETSET( redis );
@@ -10,6 +10,7 @@
 
 #include "Command.h"
 #include "CRedisClient.h"
+#include "CRedisTransaction.h"
 #include <stdio.h>
 #include <sstream>
 #include "RdException.hpp"
@@ -103,6 +104,36 @@ void TranSactionMain( void )
             REDIS_DEBUGOUT("transaction exec successful","");
         }
 
+        //-----------------------------CRedisTransaction-----------------------------
+        REDIS_DEBUGOUT("test CRedisTransaction, one round trip","");
+        result.clear();
+        CRedisTransaction trans( redis );
+        trans.watch( "yuhaiyang" );
+        trans.add( CMD_SET ) << "yuhaiyang" << "nan";
+        trans.add( CMD_INCR ) << "yuhaiyangCounter";
+        trans.add( CMD_GET ) << "yuhaiyang";
+        if ( !trans.exec( result ) )
+        {
+            REDIS_DEBUGOUT("transaction exec false","");
+        }else
+        {
+            REDIS_DEBUGOUT("transaction exec successful","");
+        }
+        REDIS_DEBUGOUT("result", result );
+
+        trans.add( CMD_INCR ) << "yuhaiyangCounter";
+        trans.add( "NOSUCHCOMMAND" );
+        try
+        {
+            trans.exec( result );
+        }catch( ReplyErr& e )
+        {
+            REDIS_DEBUGOUT("transaction discarded", e.what() );
+        }
+        string pong;
+        redis.ping( pong );
+        REDIS_DEBUGOUT("ping after discarded transaction", pong );
+
     }catch ( std::exception& e )
     {
         std::cout << e.what() << std::endl;
@@ -0,0 +1,335 @@
+/**
+ * @file	CRedisCache.cpp
+ * @brief 客户端缓存：GET/HGET/HMGET 的结果缓存在本地分片 LRU 中，由 CLIENT TRACKING 使其失效。
+ */
+
+#include "CRedisCache.h"
+#include <chrono>
+
+CRedisCache::CRedisCache( uint64_t capacity, uint32_t shardNum ):
+    _shardCapacity( 0 ),
+    _maxTtl( 0 ),
+    _enabled( true ),
+    _listening( false ),
+    _listenerId( -1 )
+{
+    if ( 0 == shardNum )
+    {
+        shardNum = 1;
+    }
+    _shardCapacity = std::max<uint64_t>( capacity / shardNum, 1 );
+    _shards.reserve( shardNum );
+    for ( uint32_t i = 0; i < shardNum; ++i )
+    {
+        Shard* pShard = new Shard;
+        pShard->size = 0;
+        pShard->epoch = 0;
+        pShard->hits = 0;
+        pShard->misses = 0;
+        pShard->evictions = 0;
+        pShard->invalidations = 0;
+        _shards.push_back( std::unique_ptr<Shard>( pShard ) );
+    }
+}
+
+CRedisCache::~CRedisCache()
+{
+    stopListen();
+}
+
+void CRedisCache::setMaxTtl( uint64_t ms )
+{
+    _maxTtl = ms;
+}
+
+void CRedisCache::listen( const string &host, UInt16 port, const string &password )
+{
+    stopListen();
+
+    _listener.connect( host, port );
+    if ( !password.empty() )
+    {
+        _listener.auth( password );
+    }
+    int64_t id = _listener.clientId();
+    Command cmd( "SUBSCRIBE" );
+    cmd << "__redis__:invalidate";
+    CResult result;
+    _listener._getArry( cmd, result );
+    // wait for messages as long as it takes, stopListen() wakes the thread up.
+    _listener._socket.setReceiveTimeout( 0 );
+
+    // keys cached before were not tracked for this connection.
+    invalidateAll();
+    _listenerId = id;
+    _listening = true;
+    _enabled = true;
+    _listenThread.start( __onRunCallBack, this );
+}
+
+void CRedisCache::stopListen( void )
+{
+    if ( _listenerId < 0 )
+    {
+        return;
+    }
+    _listening = false;
+    try
+    {
+        _listener._socket.shutdown();
+    }catch( ... )
+    {
+        // the connection is already broken, the thread is stopping anyway.
+    }
+    _listenThread.join();
+    _listener.closeConnect();
+    _listenerId = -1;
+}
+
+int64_t CRedisCache::getListenerId( void ) const
+{
+    return _listening ? _listenerId.load() : -1;
+}
+
+bool CRedisCache::find( const string &key, const string *field, string &value, bool &exists )
+{
+    if ( !_enabled )
+    {
+        return false;
+    }
+    Shard& shard = _shard( key );
+    Poco::FastMutex::ScopedLock lock( shard.mutex );
+
+    MapEntry::iterator it = shard.index.find( key );
+    if ( shard.index.end() == it )
+    {
+        ++shard.misses;
+        return false;
+    }
+    ListEntry::iterator entry = it->second;
+    if ( 0 != entry->expireAt && entry->expireAt <= _nowMs() )
+    {
+        _erase( shard, entry );
+        ++shard.misses;
+        return false;
+    }
+
+    const Value* pValue = NULL;
+    if ( NULL == field )
+    {
+        if ( !entry->hash )
+        {
+            pValue = &entry->value;
+        }
+    }else if ( entry->hash )
+    {
+        MapField::const_iterator fit = entry->fields.find( *field );
+        if ( entry->fields.end() != fit )
+        {
+            pValue = &fit->second;
+        }
+    }
+    if ( NULL == pValue )
+    {
+        ++shard.misses;
+        return false;
+    }
+
+    shard.lru.splice( shard.lru.begin(), shard.lru, entry );
+    ++shard.hits;
+    value = pValue->data;
+    exists = pValue->exists;
+    return true;
+}
+
+uint64_t CRedisCache::epoch( const string &key )
+{
+    Shard& shard = _shard( key );
+    Poco::FastMutex::ScopedLock lock( shard.mutex );
+    return shard.epoch;
+}
+
+void CRedisCache::store( const string &key, const string *field, const string &value, bool exists,
+                         int64_t pttl, uint64_t epoch )
+{
+    if ( !_enabled || 0 == pttl )
+    {
+        return;
+    }
+    if ( -2 == pttl )
+    {
+        exists = false;
+    }
+    uint64_t ttl = ( pttl > 0 ) ? pttl : 0;
+    if ( 0 != _maxTtl && ( 0 == ttl || ttl > _maxTtl ) )
+    {
+        ttl = _maxTtl;
+    }
+
+    Shard& shard = _shard( key );
+    Poco::FastMutex::ScopedLock lock( shard.mutex );
+    if ( epoch != shard.epoch )
+    {
+        // invalidated while it was being read, it may be stale already.
+        return;
+    }
+
+    bool hash = ( NULL != field );
+    MapEntry::iterator it = shard.index.find( key );
+    if ( shard.index.end() != it && it->second->hash != hash )
+    {
+        _erase( shard, it->second );
+        it = shard.index.end();
+    }
+    bool created = ( shard.index.end() == it );
+    if ( created )
+    {
+        shard.lru.push_front( Entry() );
+        shard.lru.front().key = key;
+        shard.lru.front().hash = hash;
+        shard.index[key] = shard.lru.begin();
+    }else
+    {
+        shard.lru.splice( shard.lru.begin(), shard.lru, it->second );
+    }
+    Entry& entry = shard.lru.front();
+
+    Value* pValue = NULL;
+    if ( !hash )
+    {
+        shard.size += created ? 1 : 0;
+        pValue = &entry.value;
+    }else
+    {
+        std::pair<MapField::iterator, bool> ret = entry.fields.insert( MapField::value_type( *field, Value() ) );
+        shard.size += ret.second ? 1 : 0;
+        pValue = &ret.first->second;
+    }
+    pValue->data = value;
+    pValue->exists = exists;
+    entry.expireAt = ( 0 == ttl ) ? 0 : _nowMs() + ttl;
+
+    while ( shard.size > _shardCapacity && shard.lru.size() > 1 )
+    {
+        shard.evictions += _erase( shard, --shard.lru.end() );
+    }
+}
+
+void CRedisCache::invalidate( const string &key )
+{
+    Shard& shard = _shard( key );
+    Poco::FastMutex::ScopedLock lock( shard.mutex );
+    ++shard.epoch;
+    MapEntry::iterator it = shard.index.find( key );
+    if ( shard.index.end() != it )
+    {
+        _erase( shard, it->second );
+        ++shard.invalidations;
+    }
+}
+
+void CRedisCache::invalidate( const CResult &keys )
+{
+    if ( REDIS_REPLY_NIL == keys.getType() )
+    {
+        // FLUSHDB, FLUSHALL...
+        invalidateAll();
+        return;
+    }
+    if ( !keys.isAggregate() )
+    {
+        invalidate( static_cast<const string&>( keys ) );
+        return;
+    }
+    CResult::ListCResult::const_iterator it = keys.getArry().begin();
+    CResult::ListCResult::const_iterator end = keys.getArry().end();
+    for ( ; it != end; ++it )
+    {
+        invalidate( static_cast<const string&>( *it ) );
+    }
+}
+
+void CRedisCache::invalidateAll( void )
+{
+    for ( size_t i = 0; i < _shards.size(); ++i )
+    {
+        Shard& shard = *_shards[i];
+        Poco::FastMutex::ScopedLock lock( shard.mutex );
+        ++shard.epoch;
+        shard.invalidations += shard.index.size();
+        shard.lru.clear();
+        shard.index.clear();
+        shard.size = 0;
+    }
+}
+
+CRedisCache::Stats CRedisCache::getStats( void ) const
+{
+    Stats stats = { 0, 0, 0, 0, 0 };
+    for ( size_t i = 0; i < _shards.size(); ++i )
+    {
+        Shard& shard = *_shards[i];
+        Poco::FastMutex::ScopedLock lock( shard.mutex );
+        stats.hits += shard.hits;
+        stats.misses += shard.misses;
+        stats.evictions += shard.evictions;
+        stats.invalidations += shard.invalidations;
+        stats.size += shard.size;
+    }
+    return stats;
+}
+
+//----------------------------------------------private----------------------------------------------------
+CRedisCache::Shard &CRedisCache::_shard( const string &key )
+{
+    return *_shards[std::hash<string>()( key ) % _shards.size()];
+}
+
+uint64_t CRedisCache::_erase( Shard &shard, ListEntry::iterator it )
+{
+    uint64_t num = it->hash ? it->fields.size() : 1;
+    shard.size -= num;
+    shard.index.erase( it->key );
+    shard.lru.erase( it );
+    return num;
+}
+
+void CRedisCache::_listen( void )
+{
+    CResult message;
+    while ( _listening )
+    {
+        try
+        {
+            _listener._getReply( message );
+        }catch( ... )
+        {
+            break;
+        }
+        // [ "message", "__redis__:invalidate", keys ]
+        if ( message.isAggregate() && 3 == message.getArry().size() && "message" == message.getArry()[0] )
+        {
+            invalidate( message.getArry()[2] );
+        }
+    }
+
+    // invalidations may be lost from now on, nothing cached can be trusted.
+    _enabled = false;
+    _listening = false;
+    invalidateAll();
+}
+
+int64_t CRedisCache::_nowMs( void )
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch() ).count();
+}
+
+void CRedisCache::__onRunCallBack( void *pVoid )
+{
+    CRedisCache* pCache = static_cast<CRedisCache*>( pVoid );
+    if ( pCache )
+    {
+        pCache->_listen();
+    }
+}
@@ -0,0 +1,174 @@
+/**
+ * @file	CRedisCache.h
+ * @brief 客户端缓存：GET/HGET/HMGET 的结果缓存在本地分片 LRU 中，由 CLIENT TRACKING 使其失效。
+ * 命中时不访问 socket。
+ *
+ * CRedisCache cache( 100000 );
+ * cache.listen( "127.0.0.1", 6379 );	// invalidations come through a connection of the cache.
+ * redis.enableCache( &cache );			// or, with RESP3 and one connection only: redis.hello( result ) first.
+ * redis.get( key, value );				// served from the cache until key is changed.
+ */
+
+#ifndef CREDISCACHE_H
+#define CREDISCACHE_H
+
+#include <list>
+#include <memory>
+#include <atomic>
+#include <unordered_map>
+#include <Poco/Mutex.h>
+#include <Poco/Thread.h>
+#include "CRedisClient.h"
+
+class CRedisCache
+{
+public:
+    ///< counters summed over all the shards.
+    struct Stats
+    {
+        uint64_t hits;				///< lookups served from the cache.
+        uint64_t misses;			///< lookups that went to redis.
+        uint64_t evictions;			///< values dropped to stay within the capacity.
+        uint64_t invalidations;		///< keys dropped because redis said they changed.
+        uint64_t size;				///< values cached now.
+    };
+
+    enum
+    {
+        DEFAULT_CAPACITY = 64 * 1024,	///< values cached at most by default.
+        DEFAULT_SHARD_NUM = 16			///< independent LRU lists, each with its own lock.
+    };
+
+    /**
+     * @brief CRedisCache
+     * @param capacity [in] values cached at most, a field of a hash is one value.
+     * @param shardNum [in] keys are spread over shardNum LRU lists, so threads sharing the cache
+     * rarely wait for each other.
+     */
+    explicit CRedisCache( uint64_t capacity = DEFAULT_CAPACITY, uint32_t shardNum = DEFAULT_SHARD_NUM );
+    ~CRedisCache();
+
+    /**
+     * @brief setMaxTtl cap how long a value is cached, keys without expire included.
+     * A value never outlives the PTTL of its key anyway.
+     * @param ms [in] 0: no cap.
+     */
+    void setMaxTtl( uint64_t ms );
+
+    /**
+     * @brief listen receive the invalidations on a connection of the cache, a thread reads it.
+     * The connections using the cache redirect their invalidations to it, so the cache can be
+     * shared by several connections, eg: all of a pool, with RESP2 or RESP3.
+     * @warning throw ConnectErr, ReplyErr... when it can not connect or subscribe.
+     * If the connection breaks later, the cache is flushed and disabled until listen() again.
+     */
+    void listen( const string& host , UInt16 port = 6379 , const string& password = "" );
+
+    /**
+     * @brief stopListen close the connection of listen(), the cache is flushed and disabled.
+     */
+    void stopListen( void );
+
+    /**
+     * @brief getListenerId
+     * @return the client id of the connection of listen(), -1 when not listening.
+     */
+    int64_t getListenerId( void ) const;
+
+    /**
+     * @brief find
+     * @param field [in] NULL for a string value.
+     * @param value [out] the value cached.
+     * @param exists [out] false: the key or the field is cached as not existing.
+     * @return false: not cached.
+     */
+    bool find( const string& key , const string* field , string& value , bool& exists );
+
+    /**
+     * @brief epoch take it before requesting a value, store() it with the value.
+     * A value is not stored when its key was invalidated in between.
+     */
+    uint64_t epoch( const string& key );
+
+    /**
+     * @brief store cache a value read from redis.
+     * @param field [in] NULL for a string value.
+     * @param exists [in] false: the key or the field does not exist.
+     * @param pttl [in] PTTL of the key read with the value, -1: no expire, -2: no key.
+     * @param epoch [in] see epoch().
+     */
+    void store( const string& key , const string* field , const string& value , bool exists ,
+                int64_t pttl , uint64_t epoch );
+
+    void invalidate( const string& key );
+
+    /**
+     * @brief invalidate the keys of an invalidation message, an array of keys. NIL means all.
+     */
+    void invalidate( const CResult& keys );
+
+    void invalidateAll( void );
+
+    Stats getStats( void ) const;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN( CRedisCache );
+
+    struct Value
+    {
+        string data;
+        bool exists;
+    };
+    typedef std::unordered_map<string, Value> MapField;
+
+    ///< values of a key.
+    struct Entry
+    {
+        string key;
+        bool hash;				///< values are in fields, not in value.
+        Value value;
+        MapField fields;
+        int64_t expireAt;		///< steady clock in ms, 0: never.
+    };
+    typedef std::list<Entry> ListEntry;
+    typedef std::unordered_map<string, ListEntry::iterator> MapEntry;
+
+    struct Shard
+    {
+        Poco::FastMutex mutex;
+        ListEntry lru;			///< the most recently used at the front.
+        MapEntry index;
+        uint64_t size;			///< values cached.
+        uint64_t epoch;			///< increased by each invalidation.
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        uint64_t invalidations;
+    };
+
+    Shard& _shard( const string& key );
+
+    /**
+     * @brief _erase drop an entry, the lock of shard is held.
+     * @return number of values dropped.
+     */
+    uint64_t _erase( Shard& shard , ListEntry::iterator it );
+
+    void _listen( void );
+
+    static int64_t _nowMs( void );
+
+    static void __onRunCallBack( void* pVoid );
+
+    std::vector<std::unique_ptr<Shard>> _shards;
+    uint64_t _shardCapacity;		///< values cached at most by each shard.
+    uint64_t _maxTtl;				///< ms, 0: no cap.
+
+    std::atomic<bool> _enabled;		///< false: the invalidations may be lost, nothing is served.
+    std::atomic<bool> _listening;	///< the thread of listen() is running.
+    std::atomic<int64_t> _listenerId;	///< -1 when listen() is not called or stopped.
+    CRedisClient _listener;			///< receives the invalidations with listen().
+    Poco::Thread _listenThread;
+};
+
+#endif // CREDISCACHE_H
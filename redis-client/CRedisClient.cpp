@@ -10,17 +10,44 @@
 
 
 #include "CRedisClient.h"
+#include "CRedisCache.h"
+#include "CStringsHandler.h"
 #include "Poco/Types.h"
+#include <limits.h>
 
 
-const char CRedisClient:: PREFIX_REPLY_STATUS = '+';
-const char CRedisClient:: PREFIX_REPLY_ERR = '-';
-const char CRedisClient:: PREFIX_REPLY_INT = ':';
-const char CRedisClient:: PREFIX_BULK_REPLY = '$';
-const char CRedisClient:: PREFIX_MULTI_BULK_REPLY = '*';
+/**
+ * @brief _checkStrings check the type of a reply streamed by CStringsHandler, like _getArry
+ * does with a CResult.
+ */
+static bool _checkStrings( Command& cmd, const CStringsHandler& handler, uint64_t& num )
+{
+    if ( handler.isNil() )
+    {
+        return false;
+    }
+    if ( handler.isError() )
+    {
+        throw ReplyErr( handler.getError() );
+    }
+    if ( !handler.isArray() )
+    {
+       throw ProtocolErr( cmd.getCommand() + ": data recved is not arry" );
+    }
+
+    num = handler.getCount();
+    return true;
+}
 
 //==============================based method====================================
-CRedisClient::CRedisClient()
+CRedisClient::CRedisClient():
+    _unreadReplies( 0 ),
+    _protover( 2 ),
+    _dbIndex( 0 ),
+    _hasPush( false ),
+    _readingPubSub( false ),
+    _pCache( NULL ),
+    _trackId( -1 )
 {
     Timespan timeout( 5 ,0 );
     _timeout = timeout;
@@ -33,18 +60,32 @@ CRedisClient::~CRedisClient()
 
 void CRedisClient::setAddress(const string &ip, UInt16 port)
 {
+    if ( !ip.empty() && '/' == ip[0] )
+    {
+        _unixPath = ip;
+        return;
+    }
     Net::SocketAddress addr( ip, port );
     _addr =  addr;
+    _unixPath.clear();
     return;
 }
 
 string CRedisClient::getAddrip()
 {
+    if ( !_unixPath.empty() )
+    {
+        return _unixPath;
+    }
     return _addr.host().toString();
 }
 
 string CRedisClient::getAddr()
 {
+    if ( !_unixPath.empty() )
+    {
+        return _unixPath;
+    }
     return _addr.toString();
 }
 
@@ -56,20 +97,112 @@ void CRedisClient::setTimeout(long seconds, long microseconds)
     _timeout =  timeout;
 }
 
+void CRedisClient::setTransport( CRedisTransport::Type type )
+{
+    _socket.setTransport( type );
+}
+
+CRedisTransport::Type CRedisClient::getTransport( void ) const
+{
+    return _socket.getTransport();
+}
+
+void CRedisClient::setRecvBuffer( uint32_t initSize, uint32_t maxSize )
+{
+    _socket.setBufferPolicy( initSize, maxSize );
+}
+
+void CRedisClient::shrinkRecvBuffer( void )
+{
+    _socket.shrinkBuffer();
+}
+
+void CRedisClient::setMaxRecvSize( uint64_t maxSize )
+{
+    _parser.setMaxSize( maxSize );
+}
+
+void CRedisClient::setPushCallback( const PushCallback &callback )
+{
+    _pushCallback = callback;
+}
+
+void CRedisClient::enableCache( CRedisCache *pCache )
+{
+    if ( 0 != _unreadReplies )
+    {
+        reconnect();
+    }
+    if ( NULL == pCache )
+    {
+        if ( NULL != _pCache )
+        {
+            _pCache = NULL;
+            Command cmd( "CLIENT" );
+            cmd << "TRACKING" << "OFF";
+            CResult result;
+            _handshake( cmd, result );
+        }
+        return;
+    }
+    if ( 3 != _protover && pCache->getListenerId() < 0 )
+    {
+        throw ProtocolErr( "client side caching needs RESP3 or CRedisCache::listen()" );
+    }
+    _pCache = pCache;
+    _track();
+}
+
 
 void CRedisClient::connect( const string &ip, UInt16 port )
 {
     setAddress( ip, port );
-    _socket.connect( _addr, _timeout );
-    _socket.setSendTimeout( _timeout );
-    _socket.setReceiveTimeout( _timeout );
+    connect();
 }
 
 void CRedisClient::connect()
 {
-    _socket.connect( _addr,_timeout );
+    _socket.resetBuffer();
+    if ( _unixPath.empty() )
+    {
+        _socket.connect( _addr,_timeout );
+    }else
+    {
+        _socket.connectUnix( _unixPath, _timeout );
+    }
     _socket.setSendTimeout( _timeout );
     _socket.setReceiveTimeout( _timeout );
+    _unreadReplies = 0;
+    _hasPush = false;
+    // a new connection is not authenticated and uses db 0, set it up as the old one was.
+    if ( !_password.empty() )
+    {
+        Command cmd( "AUTH" );
+        cmd << _password;
+        CResult result;
+        _handshake( cmd, result );
+    }
+    if ( 0 != _dbIndex )
+    {
+        Command cmd( "SELECT" );
+        cmd << _dbIndex;
+        CResult result;
+        _handshake( cmd, result );
+    }
+    if ( 2 != _protover )
+    {
+        CResult result;
+        _hello( result, _protover );
+    }
+    if ( NULL != _pCache )
+    {
+        // keys read on the old connection are not tracked any more.
+        _pCache->invalidateAll();
+        if ( 3 == _protover || _pCache->getListenerId() >= 0 )
+        {
+            _track();
+        }
+    }
 }
 
 void CRedisClient::reconnect()
@@ -88,8 +221,7 @@ void CRedisClient::closeConnect()
 //{
 //    try
 //    {
-//        _socket.clearBuffer();
-//
+//    //
 //        Command cmd( "PING" );
 //        _sendCommand( cmd );
 //        DEBUGOUT( "send", string( cmd ) );
@@ -115,14 +247,22 @@ void CRedisClient::closeConnect()
 
 void CRedisClient::_sendCommand( const string &cmd )
 {
+    // A reply from an earlier request was never read (timeout, exception...),
+    // the stream is out of step. Reconnect instead of draining the socket.
+    if ( 0 != _unreadReplies )
+    {
+        reconnect();
+    }
+    ++_unreadReplies;
+
     const char* sdData = cmd.data();
     size_t sdLen = cmd.length();
 
     size_t sded = 0;
-    int sd = 0;
+    size_t sd = 0;
     do{
-        sd = _socket.sendBytes( sdData, sdLen-sded );
-        if ( sd <= 0 )
+        sd = _socket.send( sdData, sdLen-sded );
+        if ( 0 == sd )
         {
             throw ConnectErr("sendByte exception!");
         }
@@ -132,82 +272,423 @@ void CRedisClient::_sendCommand( const string &cmd )
     return ;
 }
 
+void CRedisClient::_sendCommand( Command &cmd )
+{
+    _iov.clear();
+    cmd.makeIovec( _iov );
+    _sendRequests( _iov, 1 );
+}
+
+void CRedisClient::_sendRequests( Command::VecIovec &iov, uint32_t num )
+{
+    if ( 0 != _unreadReplies )
+    {
+        reconnect();
+    }
+    _unreadReplies += num;
+    _sendIovec( iov );
+}
+
+void CRedisClient::_sendIovec( Command::VecIovec &iov )
+{
+    size_t first = 0;
+    while ( first < iov.size() )
+    {
+        int count = static_cast<int>( std::min<size_t>( iov.size() - first, IOV_MAX ) );
+        size_t sd = _socket.sendv( &iov[first], count );
+
+        // skip the buffers sent completely, continue a partial one from where it stopped.
+        while ( first < iov.size() && sd >= iov[first].iov_len )
+        {
+            sd -= iov[first].iov_len;
+            ++first;
+        }
+        if ( sd > 0 )
+        {
+            iov[first].iov_base = static_cast<char*>( iov[first].iov_base ) + sd;
+            iov[first].iov_len -= sd;
+        }
+    }
+}
+
 void CRedisClient::_getReply( CResult &result )
 {
-    result.clear();
-    std::string line;
-    _socket.readLine( line );
-    REDIS_DEBUGOUT( "row data",line )
-    switch ( line[0] )
-    {
-    case PREFIX_REPLY_INT:
-        result.setType( REDIS_REPLY_INTEGERER );
-        result = line.substr( 1 );
-        break;
-    case PREFIX_REPLY_STATUS:
-        result.setType( REDIS_REPLY_STATUS );
-        result = line.substr( 1 );
-        break;
-    case PREFIX_REPLY_ERR:
-        result.setType( REDIS_REPLY_ERROR );
-        result = line.substr( 1 );
+    _readReply( result );
+    _replyDone();
+}
+
+void CRedisClient::_replyDone( void )
+{
+    // messages pushed in subscribe mode were not requested.
+    if ( 0 != _unreadReplies )
+    {
+        --_unreadReplies;
+    }
+}
+
+void CRedisClient::_readReply( CResult &result )
+{
+    _readPushes();
+    if ( _hasPush )
+    {
+        _hasPush = false;
+        result = std::move( _push );
+        return;
+    }
+    _parser.reset( result );
+    _runParser();
+    REDIS_DEBUGOUT( "reply", result )
+}
+
+bool CRedisClient::_streamReply( Command &cmd, CRedisReplyHandler &handler )
+{
+    _sendCommand( cmd );
+    _readPushes();
+    if ( _hasPush )
+    {
+        // a push is not the reply cmd expects.
+        _hasPush = false;
+        throw ProtocolErr( cmd.getCommand() + ": unknow type" );
+    }
+    _parser.reset( handler );
+    if ( CRedisParser::ABORTED == _runParser() )
+    {
+        // the rest of the reply is left unread, the next request reconnects.
+        return false;
+    }
+    _replyDone();
+    return true;
+}
+
+CRedisParser::Status CRedisClient::_runParser( void )
+{
+    while ( 1 )
+    {
+        //------large bulk string: receive straight into its buffer, no bounce through the socket buffer.
+        size_t left = _parser.bulkLeft();
+        if ( 0 == _socket.bufferedSize() && left >= _socket.getBufferSize() )
+        {
+            char* pDest = NULL;
+            _parser.bulkBuffer( pDest );
+            if ( !_parser.bulkFilled( _socket.receiveDirect( pDest, left ) ) )
+            {
+                return CRedisParser::ABORTED;
+            }
+            continue;
+        }
+
+        _socket.fillBuffer();
+        size_t consumed = 0;
+        CRedisParser::Status status = _parser.feed( _socket.bufferedData(), _socket.bufferedSize(), consumed );
+        _socket.consume( consumed );
+        if ( CRedisParser::NEED_MORE != status )
+        {
+            return status;
+        }
+    }
+}
+
+char CRedisClient::_readHead( Command &cmd )
+{
+    _sendCommand( cmd );
+    return _recvHead( cmd );
+}
+
+char CRedisClient::_recvHead( Command &cmd )
+{
+    _readPushes();
+    if ( _hasPush )
+    {
+        // a push is not the reply cmd expects.
+        _hasPush = false;
+        throw ProtocolErr( cmd.getCommand() + ": unknow type" );
+    }
+    _socket.readLine( _line );
+    if ( _line.empty() )
+    {
+        throw ProtocolErr( cmd.getCommand() + ": recv empty line" );
+    }
+
+    char type = _line[0];
+    switch ( type )
+    {
+    case CRedisParser::PREFIX_REPLY_ERR:
+        _replyDone();
+        throw ReplyErr( _line.substr( 1 ) );
+    case CRedisParser::PREFIX_REPLY_INT:
+    case CRedisParser::PREFIX_REPLY_STATUS:
+    case CRedisParser::PREFIX_REPLY_DOUBLE:
+    case CRedisParser::PREFIX_REPLY_BOOL:
+    case CRedisParser::PREFIX_REPLY_BIGNUM:
+        _replyDone();
         break;
-    case PREFIX_BULK_REPLY:
-        result.setType( REDIS_REPLY_STRING );
-        _replyBulk( result,line );
+    case CRedisParser::PREFIX_REPLY_NULL:
+        _replyDone();
+        return 0;
+    case CRedisParser::PREFIX_BULK_REPLY:
+    case CRedisParser::PREFIX_MULTI_BULK_REPLY:
+        if ( 0 == _line.compare( 1, string::npos, "-1" ) )
+        {
+            _replyDone();
+            return 0;
+        }
         break;
-    case PREFIX_MULTI_BULK_REPLY:
-        result.setType( REDIS_REPLY_ARRAY );
-        _replyMultiBulk( result,line );
+    case CRedisParser::PREFIX_BLOB_ERR_REPLY:
+    {
+        string error;
+        _socket.readN( CRedisParser::parseLength( _line.data() + 1, _line.size() - 1 ), error );
+        _readCRLF();
+        _replyDone();
+        throw ReplyErr( error );
+    }
+    case CRedisParser::PREFIX_VERBATIM_REPLY:
+    case CRedisParser::PREFIX_MAP_REPLY:
+    case CRedisParser::PREFIX_SET_REPLY:
         break;
     default:
-        throw ProtocolErr( "unknow type" );
-        break;
+        throw ProtocolErr( cmd.getCommand() + ": unknow type" );
     }
-    return;
+    return type;
 }
 
+void CRedisClient::_readPushes( bool wait )
+{
+    if ( _hasPush || ( !_pushCallback && NULL == _pCache ) )
+    {
+        return;
+    }
+    while ( 1 )
+    {
+        if ( !wait && 0 == _socket.bufferedSize() && _socket.available() <= 0 )
+        {
+            return;
+        }
+        _socket.fillBuffer();
+        if ( CRedisParser::PREFIX_PUSH_REPLY != *_socket.bufferedData() )
+        {
+            return;
+        }
+        _parser.reset( _push );
+        _runParser();
+        REDIS_DEBUGOUT( "push", _push )
 
+        // [ "invalidate", keys ]
+        const CResult::ListCResult& arry = _push.getArry();
+        if ( _readingPubSub && _isPubSubReply( arry ) )
+        {
+            // subscribe and unsubscribe wait for it.
+            _hasPush = true;
+            return;
+        }else if ( NULL != _pCache && 2 == arry.size() && "invalidate" == arry[0] )
+        {
+            _pCache->invalidate( arry[1] );
+        }else if ( _pushCallback )
+        {
+            _pushCallback( _push );
+        }else
+        {
+            // no callback, it is returned as the reply being read, see setPushCallback().
+            _hasPush = true;
+            return;
+        }
+    }
+}
 
-bool CRedisClient::_replyBulk(CResult& result , const std::string &len )
+void CRedisClient::_hello( CResult &result, int protover )
 {
-    // get the number of CResult received .
-    int64_t protoLen = _valueFromString<int64_t>(len .substr(1));
+    Command cmd( "HELLO" );
+    cmd << protover;
+    _handshake( cmd, result );
+}
 
-    if ( protoLen == -1 )
+void CRedisClient::_handshake( Command &cmd, CResult &result )
+{
+    Command::VecIovec iov;
+    cmd.makeIovec( iov );
+    ++_unreadReplies;
+    _sendIovec( iov );
+    _getReply( result );
+    if ( REDIS_REPLY_ERROR == result.getType() )
     {
-        result = "";
-        result.setType(REDIS_REPLY_NIL);
-        return false;
+        throw ReplyErr( result.getErrorString() );
     }
+}
 
-    _socket.readN( protoLen, result );
-    string tmp;
-    _socket.readN( 2, tmp );
+void CRedisClient::_track( void )
+{
+    Command cmd( "CLIENT" );
+    cmd << "TRACKING" << "ON";
+    int64_t id = _pCache->getListenerId();
+    if ( id >= 0 )
+    {
+        cmd << "REDIRECT" << id;
+    }
+    CResult result;
+    _handshake( cmd, result );
+    _trackId = id;
+}
 
-    result.setType( REDIS_REPLY_STRING );
+bool CRedisClient::_cacheUsable( void )
+{
+    if ( NULL == _pCache || 0 != _unreadReplies )
+    {
+        // a poisoned connection is reconnected by the request, the cache is flushed then.
+        return false;
+    }
+    int64_t id = _pCache->getListenerId();
+    if ( id != _trackId )
+    {
+        if ( id < 0 )
+        {
+            // the listener is gone, the cache is disabled until listen() again.
+            return false;
+        }
+        // listen() again: the keys read before were flushed, the new ones must be tracked
+        // for the new listener before they are cached.
+        _track();
+    }
+    if ( id < 0 )
+    {
+        // invalidations come on this connection, take those already received.
+        _readPushes( false );
+        if ( _hasPush )
+        {
+            // the invalidations behind a push left for the next reply are not read yet.
+            return false;
+        }
+    }
     return true;
 }
 
-uint64_t CRedisClient::_replyMultiBulk(CResult& result, const std::string &line )
+bool CRedisClient::_getCached( Command &cmd, const string &key, const string *field, string &value )
 {
-    // get the number of CResult received .
-   int64_t replyNum = _valueFromString<int64_t>( line.substr(1) );
-   //The concept of Null Array exists as well
-   if ( -1 == replyNum )
-   {
-        result.setType( REDIS_REPLY_NIL );
-        return 0;
-   }
+    bool exists = false;
+    if ( _pCache->find( key, field, value, exists ) )
+    {
+        return exists;
+    }
+
+    uint64_t epoch = _pCache->epoch( key );
+    Command pttl( "PTTL" );
+    pttl << key;
+    _iov.clear();
+    cmd.makeIovec( _iov );
+    pttl.makeIovec( _iov );
+    _sendRequests( _iov, 2 );
+
+    int64_t ttl = 0;
+    try
+    {
+        exists = _recvString( cmd, value );
+    }catch ( ReplyErr& )
+    {
+        _recvInt( pttl, ttl );
+        throw;
+    }
+    _recvInt( pttl, ttl );
+    _pCache->store( key, field, value, exists, ttl, epoch );
+    return exists;
+}
+
+void CRedisClient::_getCached( Command &cmd, const string &key, const VecString &fields, CResult &result )
+{
+    result.clear();
+    result.setType( REDIS_REPLY_ARRAY );
+    result.reserveElements( fields.size() );
+    VecString::const_iterator it = fields.begin();
+    VecString::const_iterator end = fields.end();
+    for ( ; it != end; ++it )
+    {
+        CResult& element = result.newElement();
+        bool exists = false;
+        if ( !_pCache->find( key, &( *it ), element, exists ) )
+        {
+            break;
+        }
+        element.setType( exists ? REDIS_REPLY_STRING : REDIS_REPLY_NIL );
+    }
+    if ( end == it )
+    {
+        return;
+    }
+
+    uint64_t epoch = _pCache->epoch( key );
+    Command pttl( "PTTL" );
+    pttl << key;
+    _iov.clear();
+    cmd.makeIovec( _iov );
+    pttl.makeIovec( _iov );
+    _sendRequests( _iov, 2 );
+
+    int64_t ttl = 0;
+    _getReply( result );
+    _recvInt( pttl, ttl );
+    if ( REDIS_REPLY_ERROR == result.getType() )
+    {
+        throw ReplyErr( result.getErrorString() );
+    }
+    if ( !result.isAggregate() || result.getArry().size() != fields.size() )
+    {
+       throw ProtocolErr( cmd.getCommand() + ": data recved is not arry" );
+    }
+    for ( size_t i = 0; i < fields.size(); ++i )
+    {
+        const CResult& element = result.getArry()[i];
+        _pCache->store( key, &fields[i], element, REDIS_REPLY_NIL != element.getType(), ttl, epoch );
+    }
+}
 
-   CResult ele;
-   for ( int i = 0; i< replyNum; i++ )
-   {
-       _getReply( ele );
-       result.addElement( ele );
-   }
-   
-   return result.getArry().size();
+void CRedisClient::_readCRLF( void )
+{
+    for ( int i = 0; i < 2; ++i )
+    {
+        _socket.fillBuffer();
+        if ( "\r\n"[i] != *_socket.bufferedData() )
+        {
+            throw ProtocolErr( "bulk string is not ended with CRLF" );
+        }
+        _socket.consume( 1 );
+    }
+}
+
+bool CRedisClient::_getView( Command &cmd, const ViewCallback &callback )
+{
+    char type = _readHead( cmd );
+    if ( 0 == type )
+    {
+        return false;
+    }
+
+    ReplyView view;
+    view.offset = 0;
+    if ( CRedisParser::PREFIX_REPLY_INT == type || CRedisParser::PREFIX_REPLY_STATUS == type )
+    {
+        view.data = _line.data() + 1;
+        view.len = _line.size() - 1;
+        view.total = view.len;
+        callback( view );
+        return true;
+    }
+    if ( CRedisParser::PREFIX_BULK_REPLY != type )
+    {
+        throw ProtocolErr( cmd.getCommand() + ": data recved is not string" );
+    }
+
+    //------hand out the buffered bytes in place, the buffer is refilled for the next piece.
+    view.total = CRedisParser::parseLength( _line.data() + 1, _line.size() - 1 );
+    do
+    {
+        _socket.fillBuffer();
+        view.data = _socket.bufferedData();
+        view.len = std::min<uint64_t>( _socket.bufferedSize(), view.total - view.offset );
+        callback( view );
+        _socket.consume( view.len );
+        view.offset += view.len;
+    }while ( view.offset < view.total );
+
+    _readCRLF();
+    _replyDone();
+    return true;
 }
 
 void CRedisClient::_getStringVecFromArry(const CResult::ListCResult &arry, CRedisClient::VecString &values )
@@ -221,6 +702,18 @@ void CRedisClient::_getStringVecFromArry(const CResult::ListCResult &arry, CRedi
     }
 }
 
+void CRedisClient::_getStringVecFromArry( CResult::ListCResult &&arry, CRedisClient::VecString &values )
+{
+    CResult::ListCResult::iterator it = arry.begin();
+    CResult::ListCResult::iterator end = arry.end();
+
+    values.reserve( values.size() + arry.size() );
+    for ( ; it != end; ++it )
+    {
+        values.push_back( std::move( static_cast<string&>( *it ) ) );
+    }
+}
+
 //void CRedisClient::_getStringTupleFromArry(const CResult::ListCResult &arry, CRedisClient::MapString &pairs)
 //{
 //    CResult::ListCResult::const_iterator it = arry.begin();
@@ -248,37 +741,41 @@ void CRedisClient::_getStringTupleFromArry(const CResult::ListCResult &arry, CRe
     }
 }
 
+void CRedisClient::_getStringTupleFromArry( CResult::ListCResult &&arry, CRedisClient::TupleString &pairs )
+{
+    CResult::ListCResult::iterator it = arry.begin();
+    CResult::ListCResult::iterator it2 = it;
+    CResult::ListCResult::iterator end = arry.end();
+    pairs.reserve( pairs.size() + arry.size() / 2 );
+    for ( ; it != end; ++it )
+    {
+        it2 = it++;             // the next element is value.
+        pairs.push_back( std::tuple<string,string>( std::move( static_cast<string&>( *it2 ) ),
+                                                    std::move( static_cast<string&>( *it ) ) ) );
+    }
+}
+
 
 
 
 void CRedisClient::_getResult( Command& cmd, CResult& result )
 {
-    _socket.clearBuffer();
     _sendCommand( cmd );
     _getReply( result );
 }
 
 bool CRedisClient::_getStatus(  Command& cmd , string& status )
 {
-    CResult result;
-    _socket.clearBuffer();
-    _sendCommand( cmd );
-    _getReply( result );
-
-    ReplyType type = result.getType();
-    if ( REDIS_REPLY_NIL ==  type )
+    char type = _readHead( cmd );
+    if ( 0 == type )
     {
         return false;
     }
-    if ( REDIS_REPLY_ERROR == type )
-    {
-        throw ReplyErr( result.getErrorString() );
-    }
-    if ( REDIS_REPLY_STATUS != type )
+    if ( CRedisParser::PREFIX_REPLY_STATUS != type )
     {
        throw ProtocolErr( cmd.getCommand() + ": data recved is not status" );
     }
-    status = result.getStatus();
+    status.assign( _line, 1, string::npos );
     return true;
 }
 
@@ -286,56 +783,75 @@ bool CRedisClient::_getStatus(  Command& cmd , string& status )
 
 bool CRedisClient::_getInt(  Command& cmd , int64_t& number )
 {
-    number = 0;
-    CResult result;
-    _socket.clearBuffer();
     _sendCommand( cmd );
-    _getReply( result );
+    return _recvInt( cmd, number );
+}
 
-    ReplyType type = result.getType();
-    if ( REDIS_REPLY_NIL ==  type )
+bool CRedisClient::_recvInt( Command &cmd, int64_t &number )
+{
+    number = 0;
+    char type = _recvHead( cmd );
+    if ( 0 == type )
     {
         return false;
     }
-    if ( REDIS_REPLY_ERROR == type )
+    if ( CRedisParser::PREFIX_REPLY_BOOL == type )
     {
-        throw ReplyErr( result.getErrorString() );
+        number = ( "#t" == _line ) ? 1 : 0;
+        return true;
     }
-    if ( REDIS_REPLY_INTEGERER != type )
+    if ( CRedisParser::PREFIX_REPLY_INT != type ||
+         !RdNumeric::parseInt( _line.data() + 1, _line.size() - 1, number ) )
     {
        throw ProtocolErr( cmd.getCommand() + ": data recved is not iintergerer" );
     }
-    number  = result.getInt();
     return true;
 }
 
 bool CRedisClient::_getString(  Command& cmd , string& value  )
 {
-    CResult result;
-    _socket.clearBuffer();
     _sendCommand( cmd );
-    _getReply( result );
+    return _recvString( cmd, value );
+}
 
-    ReplyType type = result.getType();
-    if ( REDIS_REPLY_NIL ==  type )
+bool CRedisClient::_recvString( Command &cmd, string &value )
+{
+    char type = _recvHead( cmd );
+    if ( 0 == type )
     {
         return false;
     }
-    if ( REDIS_REPLY_ERROR == type )
+    if ( CRedisParser::PREFIX_REPLY_DOUBLE == type || CRedisParser::PREFIX_REPLY_BIGNUM == type )
     {
-        throw ReplyErr( result.getErrorString() );
+        // RESP3 sends scores and the like as doubles, the text is kept as it is.
+        value.assign( _line, 1, string::npos );
+        return true;
     }
-    if ( REDIS_REPLY_STRING != type )
+    if ( CRedisParser::PREFIX_BULK_REPLY != type && CRedisParser::PREFIX_VERBATIM_REPLY != type )
     {
        throw ProtocolErr( cmd.getCommand() + ": data recved is not string" );
     }
-    value = result.getString();
+    int64_t len = CRedisParser::parseLength( _line.data() + 1, _line.size() - 1 );
+    if ( 0 != _parser.getMaxSize() && static_cast<uint64_t>( len ) > _parser.getMaxSize() )
+    {
+        throw MaximumErr( cmd.getCommand() + ": reply is larger than the max size" );
+    }
+    _socket.readN( len, value );
+    _readCRLF();
+    _replyDone();
+    if ( CRedisParser::PREFIX_VERBATIM_REPLY == type )
+    {
+        if ( value.size() < 4 || ':' != value[3] )
+        {
+            throw ProtocolErr( cmd.getCommand() + ": verbatim string has no format" );
+        }
+        value.erase( 0, 4 );
+    }
     return true;
 }
 
 bool CRedisClient::_getArry(Command &cmd, CResult &result)
 {
-    _socket.clearBuffer();
     _sendCommand( cmd );
     _getReply( result );
 
@@ -349,7 +865,7 @@ bool CRedisClient::_getArry(Command &cmd, CResult &result)
     {
         throw ReplyErr( result.getErrorString() );
     }
-    if ( REDIS_REPLY_ARRAY != type )
+    if ( !result.isAggregate() )
     {
        throw ProtocolErr( cmd.getCommand() + ": data recved is not arry" );
     }
@@ -360,56 +876,16 @@ bool CRedisClient::_getArry(Command &cmd, CResult &result)
 
 bool CRedisClient::_getArry(Command &cmd, VecString &values , uint64_t &num)
 {
-    _socket.clearBuffer();
-    _sendCommand( cmd );
-    CResult result;
-    _getReply( result );
-
-    ReplyType type = result.getType();
-
-    if ( REDIS_REPLY_NIL == type )
-    {
-        return false;
-    }
-    if ( REDIS_REPLY_ERROR == type )
-    {
-        throw ReplyErr( result.getErrorString() );
-    }
-    if ( REDIS_REPLY_ARRAY != type )
-    {
-       throw ProtocolErr( cmd.getCommand() + ": data recved is not arry" );
-    }
-
-    num = result.getArry().size();
-    _getStringVecFromArry( result.getArry(), values );
-    return true;
+    num = 0;
+    CStringsHandler handler( &values, NULL );
+    _streamReply( cmd, handler );
+    return _checkStrings( cmd, handler, num );
 }
 
 bool CRedisClient::_getArry(Command &cmd, CRedisClient::TupleString &pairs , uint64_t &num)
 {
     num = 0;
-    _socket.clearBuffer();
-    _sendCommand( cmd );
-    CResult result;
-    _getReply( result );
-
-    ReplyType type = result.getType();
-
-
-    if ( REDIS_REPLY_NIL == type )
-    {
-        return false;
-    }
-    if ( REDIS_REPLY_ERROR == type )
-    {
-        throw ReplyErr( result.getErrorString() );
-    }
-    if ( REDIS_REPLY_ARRAY != type )
-    {
-       throw ProtocolErr( cmd.getCommand() + ": data recved is not arry" );
-    }
-
-    num = result.getArry().size();
-    _getStringTupleFromArry( result.getArry(), pairs );
-    return true;
+    CStringsHandler handler( NULL, &pairs );
+    _streamReply( cmd, handler );
+    return _checkStrings( cmd, handler, num );
 }
@@ -12,11 +12,15 @@
 #include <stdint.h>
 #include <vector>
 #include <tuple>
-#include <Poco/Net/StreamSocket.h>
+#include <functional>
+#include <Poco/Net/SocketAddress.h>
 #include "Command.h"
 #include "redisCommon.h"
 #include "RdException.hpp"
 #include "CRedisSocket.h"
+#include "CRedisParser.h"
+
+class CRedisCache;
 
 #include "CResult.h"
 
@@ -66,19 +70,45 @@ public:
     typedef std::vector<std::tuple<string,string>> TupleString;
     typedef std::vector<bool> VecBool;
 
+    enum
+    {
+        MAX_RECV_SIZE = 1024 * 1024		///< The max number of recved data.( 1M ), see setMaxRecvSize().
+    };
+
+    /**
+     * @brief The ReplyView struct a piece of a reply borrowed from the receive buffer, not copied.
+     * A value larger than what is buffered comes in several pieces, in order.
+     */
+    struct ReplyView
+    {
+        const char* data;		///< bytes of this piece, valid until the callback returns.
+        size_t len;				///< length of this piece.
+        uint64_t offset;		///< where this piece starts in the whole value.
+        uint64_t total;			///< length of the whole value.
+    };
+    typedef std::function<void( const ReplyView& view )> ViewCallback;
+
+    /**
+     * @brief PushCallback receives the out of band data pushed by the server with RESP3,
+     * eg: pub/sub messages, invalidations of client side caching. See setPushCallback().
+     */
+    typedef std::function<void( CResult& push )> PushCallback;
+
 	CRedisClient( );
 	~CRedisClient( );
 
 	/**
 	 * @brief setAddress set redis-server ipaddress.
-	 * @param ip	redis-server ip.
+	 * @param ip	redis-server ip, or the path of its unix socket, eg: /var/run/redis/redis.sock.
+	 * A path starts with '/', port is ignored then.
 	 * @param port redis-server port.
+	 * @warning a unix socket needs CRedisTransport::TRANSPORT_POSIX, the default transport.
 	 */
 	void setAddress( const string& ip , UInt16 port );
 
 	/**
 	 * @brief getAddrip
-	 * @return get redis-server ip
+	 * @return get redis-server ip, the path of a unix socket.
 	 */
 	string getAddrip( void );
 
@@ -101,9 +131,66 @@ public:
 	 */
 	void setTimeout( long seconds , long microseconds );
 
+	/**
+	 * @brief setTransport choose how the bytes are sent and received, it takes effect from the
+	 * next connect(), the current connection is closed.
+	 * @param type [in] CRedisTransport::TRANSPORT_POSIX by default: non-blocking socket, poll()
+	 * timeouts. CRedisTransport::TRANSPORT_POCO: Poco::Net::StreamSocket.
+	 * CRedisTransport::TRANSPORT_IO_URING: io_uring, or TRANSPORT_POSIX when it is not available,
+	 * see getTransport().
+	 */
+	void setTransport( CRedisTransport::Type type );
+	CRedisTransport::Type getTransport( void ) const;
+
+	/**
+	 * @brief setRecvBuffer set the size policy of the receive buffer.
+	 * @param initSize [in] size the buffer starts with, default CRedisSocket::RECEIVE_BUFFER_SIZE.
+	 * @param maxSize [in] size the buffer may grow to while large replies are received.
+	 * @note call it before setTransport( CRedisTransport::TRANSPORT_IO_URING ), the provided
+	 * buffers of io_uring are initSize each, see CRedisUringTransport.
+	 */
+	void setRecvBuffer( uint32_t initSize , uint32_t maxSize );
+
+	/**
+	 * @brief shrinkRecvBuffer shrink a grown receive buffer back to its initial size.
+	 */
+	void shrinkRecvBuffer( void );
+
+	/**
+	 * @brief setMaxRecvSize limit the bytes of one reply, eg: MAX_RECV_SIZE.
+	 * A longer reply is refused as soon as its lengths are seen, before its data is received.
+	 * @param maxSize [in] 0: no limit, which is the default.
+	 * @warning the requests throw MaximumErr on a longer reply, the connection is reconnected
+	 * by the next request.
+	 */
+	void setMaxRecvSize( uint64_t maxSize );
+
+	/**
+	 * @brief setPushCallback take the pushes met while replies are read out of the way.
+	 * Without a callback a push is returned as the reply being read, like messages of
+	 * SUBSCRIBE are with RESP2. The replies of subscribe() and unsubscribe(), pushed with
+	 * RESP3, are read by them and never handed to the callback.
+	 * @param callback [in] called on the thread reading the reply, before the reply is read.
+	 * An empty one removes the callback.
+	 */
+	void setPushCallback( const PushCallback& callback );
+
+	/**
+	 * @brief enableCache serve get(), hget() and hmget() from pCache, the server tells it
+	 * which keys change with CLIENT TRACKING. A hit does not touch the socket.
+	 * With RESP3 and no CRedisCache::listen(), invalidations are pushed on this connection:
+	 * pCache must not be shared with other connections then, and a hit checks whether
+	 * anything has been pushed without waiting. Only the invalidations are taken by pCache,
+	 * other pushes go to the push callback or are returned as the reply, see setPushCallback().
+	 * Tracking is enabled again each time the client reconnects, the cache is flushed then.
+	 * @param pCache [in] it must outlive the client or be disabled with NULL first.
+	 * @warning throw ProtocolErr when the connection is RESP2 and pCache is not listening.
+	 */
+	void enableCache( CRedisCache* pCache );
+
 	/**
 	 * @brief connect to redis-server
-	 * @param ip [in] host ip
+	 * @param ip [in] host ip, or the path of a unix socket, see setAddress().
 	 * @param port [in] host port
 	 * @warning Will throw an exception when the connection fails.
 	 */
@@ -131,6 +218,22 @@ public:
 	 */
     bool ping( string &value );
 
+	/**
+	 * @brief hello switch the protocol of the connection, HELLO 3 enables RESP3 replies:
+	 * maps, sets, doubles, booleans, big numbers, verbatim strings, attributes and pushes.
+	 * The protocol is switched again each time the client reconnects.
+	 * @param result [out] the properties of the server, a map with RESP3.
+	 * @param protover [in] 2 or 3.
+	 * @warning throw ReplyErr when the server does not support it, eg: older than redis 6.
+	 */
+	void hello( CResult& result , int protover = 3 );
+
+	/**
+	 * @brief getProtocol
+	 * @return 2 or 3, the protocol negotiated by hello().
+	 */
+	int getProtocol( void ) const;
+
 	/**
 	 * @brief 请求服务器关闭与当前客户端的连接。
 	 * @return 成功返回true，失败抛异常
@@ -149,6 +252,7 @@ public:
 	 * @brief 如果开启了密码保护的话，在每次连接 Redis 服务器之后，就要使用 AUTH 命令解锁，解锁之后才能使用其他 Redis 命令
 	 * @param password[in]认证密码
 	 * @return 密码匹配时返回true,失败抛异常
+	 * 成功后密码被记住，connect()/reconnect() 建立新连接时自动重新认证。
 	 */
     void auth( const string &password );
 
@@ -156,6 +260,7 @@ public:
 	 * @brief 切换到指定的数据库，数据库索引号 index 用数字值指定，以 0 作为起始索引值。
 	 * @param index [in]数据库索引号
 	 * @return 成功返回true，失败抛异常
+	 * 成功后索引被记住，connect()/reconnect() 建立新连接时自动重新选择。
 	 */
     void select( uint64_t index );
 
@@ -459,6 +564,16 @@ public:
 	 */
 	bool get( const string& key , string &value );
 
+	/**
+	 * @brief getView get without copying, the value is handed to callback piece by piece.
+	 * @param key
+	 * @param callback [in] called at least once when the key exists, also for an empty value.
+	 * @return true: get value successful, false: key is not exist.
+	 * @warning If callback throws, the rest of the reply is left unread and the connection
+	 * is reconnected by the next request.
+	 */
+	bool getView( const string& key , const ViewCallback& callback );
+
 	uint8_t getbit( const string& key , uint32_t offset );
 
 	bool getrange( const string& key , int64_t start , int64_t end , string &value );
@@ -557,6 +672,11 @@ public:
 	 */
     bool lindex(const string &key , int64_t index , string &value );
 
+    /**
+     * @brief lindexView lindex without copying, see getView.
+     */
+    bool lindexView( const string &key , int64_t index , const ViewCallback& callback );
+
 	/**
 	 * @brief return length of a list
 	 * @param key[in] name of list
@@ -635,6 +755,12 @@ public:
 	 */
     uint64_t lrange(const string &key , int64_t start , int64_t stop , VecString &value );
 
+    /**
+     * @brief lrange hand the slice to handler element by element instead of storing it.
+     * @return false: the handler stopped the reply.
+     */
+    bool lrange( const string &key , int64_t start , int64_t stop , CRedisReplyHandler& handler );
+
 	/**
 	 * @brief lpop的阻塞版本，当给定列表内没有元素弹出的时候，将阻塞，直到等待超时或发现可弹出元素为止。
 	 * @param 当给定多个 key 参数时，按参数 key 的先后顺序依次检查各个列表，弹出第一个非空列表的头元素
@@ -686,12 +812,22 @@ public:
 	 */
 	bool hget( const string& key , const string& field , std::string &value );
 
+	/**
+	 * @brief hgetView hget without copying, see getView.
+	 */
+	bool hgetView( const string& key , const string& field , const ViewCallback& callback );
+
 	uint64_t hdel( const string& key , const VecString& fields );
 
 	bool hexists( const string& key , const string& field );
 
     uint64_t hgetall( const string& key , TupleString& pairs );
 
+    /**
+     * @brief hgetall hand fields and values to handler one by one, see lrange.
+     */
+    bool hgetall( const string& key , CRedisReplyHandler& handler );
+
     int64_t hincrby( const string& key , const string& field , int64_t increment );
 
     double hincrbyfloat( const string& key , const string& field , float increment );
@@ -747,6 +883,11 @@ public:
 
 	uint64_t smembers( const string& key , VecString& members );
 
+	/**
+	 * @brief smembers hand the members to handler one by one, see lrange.
+	 */
+	bool smembers( const string& key , CRedisReplyHandler& handler );
+
 	/**
 	 * @brief smove
 	 * @param source
@@ -824,6 +965,13 @@ public:
      * @return: size of reply list.
      */
     uint64_t zrange(const string& key,const int64_t start,const int64_t stop,VecString& reply);
+
+    /**
+     * @brief zrange hand the members, each followed by its score if withScores, to handler
+     * one by one, see lrange.
+     */
+    bool zrange( const string& key , int64_t start , int64_t stop , CRedisReplyHandler& handler ,
+                 bool withScores = false );
     uint64_t zrangeWithscore(const string& key,const int64_t start,const int64_t stop,TupleString& reply);
     /**
      * @brief zrangebyscore  Return a range of members in a sorted set, by score
@@ -977,6 +1125,7 @@ public:
      */
     uint64_t zremrangebylex (const string& key,const string& min,const string& max);
 	//--------------------------transtraction method------------------------------
+	// each call below costs a round trip, CRedisTransaction sends a whole transaction in one.
 
 	void watch( const VecString& keys );
 
@@ -1009,10 +1158,18 @@ public:
 
 	uint64_t psubnumpat( );
 
+	/**
+	 * @brief punsubscribe read the reply of each pattern, or of each one subscribed when none is given.
+	 * @param result [out] the last reply: [ "punsubscribe", pattern, subscriptions left ].
+	 */
 	void punsubscribe( CResult& result, const VecString& pattern = VecString() );
 
 	void subscribe( VecString& channel , CResult& result );
 
+	/**
+	 * @brief unsubscribe read the reply of each channel, or of each one subscribed when none is given.
+	 * @param result [out] the last reply: [ "unsubscribe", channel, subscriptions left ].
+	 */
 	void unsubscribe( CResult& result, const VecString& channel = VecString() );
 
 	//-----------------------------Server---------------------------------------------------
@@ -1051,6 +1208,10 @@ public:
      * @return: None
      */
     void clientSetname (const string& connectionName);
+    /**
+     * @brief clientId Get the id of the current connection.
+     */
+    int64_t clientId( void );
     /**
      * @brief configGet Get the value of a configuration parameter.
      * @param parameter[in]
@@ -1165,25 +1326,148 @@ protected:
 	 */
 	void _sendCommand( const string& cmd );
 
+	/**
+	 * @brief _sendCommand send a Command to redis-server with writev, the buffers it
+	 * refers to are not copied.
+	 * @param cmd [in]  command will be send.
+	 */
+	void _sendCommand( Command& cmd );
+
+	/**
+	 * @brief _sendRequests send num requests encoded in iov with one write.
+	 * @param iov [in] buffers to send, it is changed while sending.
+	 * @param num [in] the number of replies expected.
+	 */
+	void _sendRequests( Command::VecIovec& iov , uint32_t num );
+
+	/**
+	 * @brief _sendIovec send all the buffers, a partial send is continued where it stopped.
+	 * @param iov [in] buffers to send, it is changed while sending.
+	 */
+	void _sendIovec( Command::VecIovec& iov );
+
+	/**
+	 * @brief _unsubscribe send cmd, read a reply for each of the num channels or patterns,
+	 * or until no subscription is left when num is 0.
+	 * @param result [out] the last reply.
+	 */
+	void _unsubscribe( Command& cmd , size_t num , CResult& result );
+
+	/**
+	 * @brief _isPubSubReply whether arry is the reply of SUBSCRIBE, UNSUBSCRIBE, PSUBSCRIBE or
+	 * PUNSUBSCRIBE, not a message.
+	 */
+	static bool _isPubSubReply( const CResult::ListCResult& arry );
+
+	/**
+	 * @brief _getReply read the reply of the oldest request that is not answered yet.
+	 * @param result [out]
+	 */
     void _getReply( CResult& result );
 
 	/**
-	 * @brief _replyBulk
-	 * @param result
-	 * @param line
-	 * @return true: successful false :not exists
+	 * @brief _replyDone a reply was read without _getReply().
+	 */
+	void _replyDone( void );
+
+	/**
+	 * @brief _readHead send cmd and read the first line of its reply into _line.
+	 * Error, NIL, integer and status replies are complete after it.
+	 * @return the type prefix of the reply, 0 for NIL.
+	 * @warning throw ReplyErr when the reply is an error.
+	 */
+	char _readHead( Command& cmd );
+
+	/**
+	 * @brief _recvHead read the first line of a reply requested already, see _readHead.
+	 * @param cmd [in] the request, for error messages.
+	 */
+	char _recvHead( Command& cmd );
+
+	/**
+	 * @brief _readPushes hand the pushes waiting before the next reply to the push callback,
+	 * or to the cache when they are invalidations. While _readingPubSub the replies of
+	 * subscribe and unsubscribe are left in _push for the reply reader, so is any push
+	 * when there is no callback.
+	 * @param wait [in] false: only what has been received already, nothing is requested.
+	 */
+	void _readPushes( bool wait = true );
+
+	/**
+	 * @brief _hello send HELLO and read its reply, see _handshake.
+	 */
+	void _hello( CResult& result , int protover );
+
+	/**
+	 * @brief _handshake send cmd and read its reply without touching _iov, so it works
+	 * while a request is being sent, eg: to set up a connection again on reconnect.
+	 * @warning throw ReplyErr when the reply is an error.
+	 */
+	void _handshake( Command& cmd , CResult& result );
+
+	/**
+	 * @brief _track enable CLIENT TRACKING for _pCache, redirected to its listener if any.
+	 * Called again it only changes where the invalidations go.
+	 */
+	void _track( void );
+
+	/**
+	 * @brief _getCached a GET or HGET through _pCache. On a miss cmd is sent with a PTTL of
+	 * key in one write, and the value is cached for no longer than the key lives.
+	 * @param field [in] NULL for GET.
+	 */
+	bool _getCached( Command& cmd , const string& key , const string* field , string& value );
+
+	/**
+	 * @brief _getCached a HMGET through _pCache, served from it only when all the fields are cached.
+	 */
+	void _getCached( Command& cmd , const string& key , const VecString& fields , CResult& result );
+
+	/**
+	 * @brief _cacheUsable redirect the tracking to the listener of _pCache again when it was
+	 * started again since, the old one is gone with the invalidations sent to it.
+	 * @return true: _pCache may serve a request now.
+	 */
+	bool _cacheUsable( void );
+
+	/**
+	 * @brief _readCRLF skip the "\r\n" after the data of a bulk string.
+	 */
+	void _readCRLF( void );
+
+	/**
+	 * @brief _getView send cmd, hand a bulk string, integer or status reply to callback in
+	 * pieces borrowed from the receive buffer.
+	 * @return false: the reply is NIL.
+	 * @warning throw ReplyErr when the reply is an error, ProtocolErr when it is an array.
 	 */
-	bool _replyBulk( CResult &result , const string& len );
+	bool _getView( Command& cmd , const ViewCallback& callback );
 
-	uint64_t _replyMultiBulk( CResult &result , const std::string &line );
+	/**
+	 * @brief _readReply feed received bytes to _parser until a whole reply is parsed.
+	 * The data of a large bulk string is received straight into result.
+	 */
+    void _readReply( CResult& result );
+
+	/**
+	 * @brief _streamReply send cmd, hand its reply to handler while it is parsed.
+	 * The handler runs as the reply comes in, a slow handler slows down the reading,
+	 * and TCP flow control slows down the server.
+	 * @return false: the handler stopped the reply, the connection is reconnected by the next request.
+	 */
+	bool _streamReply( Command& cmd , CRedisReplyHandler& handler );
+
+	/**
+	 * @brief _runParser feed received bytes to _parser until it completes or is stopped.
+	 * The data of a large bulk string is received straight into its buffer.
+	 */
+	CRedisParser::Status _runParser( void );
 
 	template< typename T >
 	T _valueFromString( const string& data )
 	{
 		T value;
-		std::istringstream istr(data);
-		istr >> value;
-		if ( istr.fail() )
+		if ( !RdNumeric::parse( data.data(), data.size(), value ) )
 		{
 			throw ConvertErr("convert from string to other type value falied");
 		}
@@ -1193,8 +1477,15 @@ protected:
 
     void _getStringVecFromArry( const CResult::ListCResult& arry , VecString& values );
 
+    /**
+     * @brief _getStringVecFromArry the payloads are moved out of arry, not copied.
+     */
+    void _getStringVecFromArry( CResult::ListCResult&& arry , VecString& values );
+
     void _getStringTupleFromArry( const CResult::ListCResult& arry , TupleString& pairs );
 
+    void _getStringTupleFromArry( CResult::ListCResult&& arry , TupleString& pairs );
+
 	/**
 	 * @brief set
 	 * @param key
@@ -1210,14 +1501,23 @@ protected:
     void _getResult(Command &cmd, CResult &result);
 
 	/**
-	 * @brief _getStatus
+	 * @brief _getStatus the reply is read from the socket buffer straight into status,
+	 * no CResult is built. So are _getInt and _getString.
 	 * @param cmd [in] Command you want send.
 	 * @param data [out] recved from server.
 	 * @return true:recv data successful. false: recv empty object.
+	 * @warning throw ProtocolErr when the reply is of another type. The rest of an unexpected
+	 * bulk string or array is left unread, the connection is reconnected by the next request.
 	 */
 	bool _getStatus( Command &cmd , string &status );
 	bool _getInt( Command &cmd , int64_t &number );
 	bool _getString( Command &cmd , string &value );
+
+	/**
+	 * @brief _recvInt _recvString read the reply of a request sent already, like _getInt and _getString.
+	 */
+	bool _recvInt( Command &cmd , int64_t &number );
+	bool _recvString( Command &cmd , string &value );
 	/**
 	 * @brief _getArry
 	 * @param cmd
@@ -1232,19 +1532,32 @@ protected:
 private:
 	DISALLOW_COPY_AND_ASSIGN( CRedisClient );
 
+	friend class CRedisPipeline;
+	friend class CRedisTransaction;
+	friend class CRedisCache;
+
 	CRedisSocket _socket;			///< redis net work class.
+	CRedisParser _parser;			///< parses the replies received by _socket.
+	string _line;					///< reply line read by _readHead, reused so it is not allocated each time.
 	Net::SocketAddress _addr;		///< redis server ip address.
+	string _unixPath;				///< path of the unix socket of redis server, empty for _addr.
 	Timespan _timeout;					///< time out.
+	Command::VecIovec _iov;				///< reused by _sendCommand.
+	uint32_t _unreadReplies;			///< replies requested but not read yet. Non-zero before a request means the connection is poisoned.
+	int _protover;						///< protocol negotiated by hello(), it is negotiated again on reconnect.
+	string _password;					///< accepted by auth(), sent again on reconnect. Empty: none.
+	uint64_t _dbIndex;					///< selected by select(), selected again on reconnect.
+	PushCallback _pushCallback;			///< receives pushes, see setPushCallback().
+	CResult _push;						///< the push read by _readPushes, see _hasPush.
+	bool _hasPush;						///< _push is the reply being read, _readReply returns it.
+	bool _readingPubSub;				///< subscribe or unsubscribe is reading its replies, pushed with RESP3.
+	CRedisCache* _pCache;				///< see enableCache(), NULL if none.
+	int64_t _trackId;					///< listener the invalidations are redirected to, -1: this connection.
 
 	enum
 	{
-		MAX_LINE_SIZE = 2048, MAX_RECV_SIZE = 1024 * 1024///< The max number of recved data.( 1M  )
+		MAX_LINE_SIZE = 2048
 	};
-	static const char PREFIX_REPLY_STATUS;
-	static const char PREFIX_REPLY_ERR;
-	static const char PREFIX_REPLY_INT;
-	static const char PREFIX_BULK_REPLY;
-	static const char PREFIX_MULTI_BULK_REPLY;
 };
 
 #endif // REDIS_H
@@ -0,0 +1,197 @@
+/**
+ * @file	CRedisCoroutine.h
+ * @brief C++20 协程接口：co_await 发送指令，等待回复时挂起协程而不阻塞线程。
+ *
+ * 指令经 CRedisMultiplexer 发送，回复到达时由读线程恢复协程，或交给 Executor 调度。
+ * 只有头文件：库本身按 C++11 编译，使用 C++20 编译的程序包含此文件即可。
+ *
+ * CRedisMultiplexer mux;
+ * mux.connect( "127.0.0.1", 6379 );
+ * CRedisCoClient redis( mux, []( std::coroutine_handle<> handle ){ workers.post( handle ); } );
+ * // in a coroutine:
+ * string value;
+ * if ( co_await redis.get( "key", value ) ) ...
+ */
+
+#ifndef CREDISCOROUTINE_H
+#define CREDISCOROUTINE_H
+
+#if __cplusplus >= 202002L && defined( __has_include )
+#if __has_include( <coroutine> )
+#include <coroutine>
+#ifdef __cpp_impl_coroutine
+#define CREDIS_HAVE_COROUTINE
+#endif
+#endif
+#endif
+
+#ifdef CREDIS_HAVE_COROUTINE
+
+#include "CRedisMultiplexer.h"
+
+/**
+ * @brief The CRedisAwaiter class is returned by CRedisCoClient, co_await it once.
+ * The command is sent when the coroutine suspends, co_await gives the converted reply,
+ * or throws the ConnectErr, ReplyErr... the blocking call would throw.
+ */
+template <typename T>
+class CRedisAwaiter
+{
+public:
+    typedef std::function<void ( std::coroutine_handle<> handle )> Executor;
+    typedef std::function<T ( CResult& reply )> Convert;
+
+    CRedisAwaiter( CRedisMultiplexer& mux, const Command& cmd, const Executor& executor, const Convert& convert ):
+        _mux( mux ),
+        _cmd( cmd ),
+        _executor( executor ),
+        _convert( convert )
+    {
+    }
+
+    bool await_ready( void ) const noexcept
+    {
+        return false;
+    }
+
+    /**
+     * @brief await_suspend the coroutine is suspended already, the reply may resume it
+     * before send() returns, nothing is touched after it.
+     * @warning throw ConnectErr when the multiplexer is not connected, co_await throws it.
+     */
+    void await_suspend( std::coroutine_handle<> handle )
+    {
+        // moved out: the executor may resume the coroutine on another thread, which destroys
+        // this awaiter before the executor returns.
+        _mux.send( _cmd, [this, handle, executor = std::move( _executor )]( CResult& reply, const std::exception_ptr& error )
+        {
+            _reply = std::move( reply );
+            _error = error;
+            if ( executor )
+            {
+                executor( handle );
+            }else
+            {
+                handle.resume();
+            }
+        } );
+    }
+
+    T await_resume( void )
+    {
+        if ( _error )
+        {
+            std::rethrow_exception( _error );
+        }
+        return _convert( _reply );
+    }
+
+private:
+    CRedisMultiplexer& _mux;
+    Command _cmd;
+    Executor _executor;
+    Convert _convert;
+    CResult _reply;
+    std::exception_ptr _error;		///< the connection failed before the reply came.
+};
+
+/**
+ * @brief The CRedisCoClient class gives awaitable commands on a CRedisMultiplexer.
+ * Thousands of coroutines may wait at the same time, they cost a queued command each,
+ * not a thread or a connection.
+ */
+class CRedisCoClient
+{
+public:
+    /**
+     * @brief Executor resumes a coroutine whose reply came, eg: posts it to a scheduler.
+     * Empty: the coroutine is resumed on the reader thread of the multiplexer, it must not
+     * block there, the replies after it wait.
+     */
+    typedef std::function<void ( std::coroutine_handle<> handle )> Executor;
+
+    /**
+     * @brief CRedisCoClient
+     * @param mux [in] connected, it must outlive the coroutines waiting on it.
+     */
+    explicit CRedisCoClient( CRedisMultiplexer& mux, const Executor& executor = Executor() ):
+        _mux( mux ),
+        _executor( executor )
+    {
+    }
+
+    /**
+     * @brief command co_await gives the reply, an error reply is stored as REDIS_REPLY_ERROR.
+     */
+    CRedisAwaiter<CResult> command( const Command& cmd )
+    {
+        return CRedisAwaiter<CResult>( _mux, cmd, _executor, []( CResult& reply )
+        {
+            return std::move( reply );
+        } );
+    }
+
+    /**
+     * @brief get co_await gives false when the key does not exist.
+     * @param value [out] set when the coroutine resumes.
+     */
+    CRedisAwaiter<bool> get( const string& key, string& value )
+    {
+        Command cmd( CMD_GET );
+        cmd << key;
+        string* pValue = &value;
+        return CRedisAwaiter<bool>( _mux, cmd, _executor, [pValue]( CResult& reply )
+        {
+            return CRedisMultiplexer::_getReply( reply, *pValue, "GET" );
+        } );
+    }
+
+    CRedisAwaiter<void> set( const string& key, const string& value )
+    {
+        Command cmd( CMD_SET );
+        cmd << key << value;
+        return CRedisAwaiter<void>( _mux, cmd, _executor, []( CResult& reply )
+        {
+            CRedisMultiplexer::_setReply( reply, "SET" );
+        } );
+    }
+
+    CRedisAwaiter<uint64_t> del( const string& key )
+    {
+        Command cmd( "DEL" );
+        cmd << key;
+        return CRedisAwaiter<uint64_t>( _mux, cmd, _executor, []( CResult& reply )
+        {
+            return static_cast<uint64_t>( CRedisMultiplexer::_intReply( reply, "DEL" ) );
+        } );
+    }
+
+    CRedisAwaiter<bool> hget( const string& key, const string& field, string& value )
+    {
+        Command cmd( CMD_HGET );
+        cmd << key << field;
+        string* pValue = &value;
+        return CRedisAwaiter<bool>( _mux, cmd, _executor, [pValue]( CResult& reply )
+        {
+            return CRedisMultiplexer::_getReply( reply, *pValue, "HGET" );
+        } );
+    }
+
+    CRedisAwaiter<uint8_t> hset( const string& key, const string& field, const string& value )
+    {
+        Command cmd( CMD_HSET );
+        cmd << key << field << value;
+        return CRedisAwaiter<uint8_t>( _mux, cmd, _executor, []( CResult& reply )
+        {
+            return static_cast<uint8_t>( CRedisMultiplexer::_intReply( reply, "HSET" ) );
+        } );
+    }
+
+private:
+    CRedisMultiplexer& _mux;
+    Executor _executor;
+};
+
+#endif // CREDIS_HAVE_COROUTINE
+
+#endif // CREDISCOROUTINE_H
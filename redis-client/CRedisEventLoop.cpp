@@ -0,0 +1,347 @@
+/**
+ * @file	CRedisEventLoop.cpp
+ * @brief 事件循环：一个 I/O 线程用 epoll 管理任意多个连接，定时器放在时间轮中。
+ */
+
+#include "CRedisEventLoop.h"
+#include <Poco/Event.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+///< the loop running on this thread, for inLoop().
+static thread_local CRedisEventLoop* t_pLoop = NULL;
+
+CRedisEventLoop::CRedisEventLoop():
+    _epollFd( -1 ),
+    _wakeFd( -1 ),
+    _running( false ),
+    _wheel( WHEEL_SLOTS ),
+    _slot( 0 ),
+    _tickTime( 0 ),
+    _nextTimerId( 0 )
+{
+    _epollFd = ::epoll_create1( EPOLL_CLOEXEC );
+    if ( _epollFd < 0 )
+    {
+        throw ConnectErr( string( "epoll_create1 exception: " ) + strerror( errno ) );
+    }
+    _wakeFd = ::eventfd( 0, EFD_NONBLOCK | EFD_CLOEXEC );
+    if ( _wakeFd < 0 )
+    {
+        int err = errno;
+        ::close( _epollFd );
+        throw ConnectErr( string( "eventfd exception: " ) + strerror( err ) );
+    }
+
+    struct epoll_event ev;
+    memset( &ev, 0, sizeof( ev ) );
+    ev.events = EPOLLIN;
+    ev.data.fd = _wakeFd;
+    ::epoll_ctl( _epollFd, EPOLL_CTL_ADD, _wakeFd, &ev );
+}
+
+CRedisEventLoop::~CRedisEventLoop()
+{
+    stop();
+    ::close( _wakeFd );
+    ::close( _epollFd );
+}
+
+void CRedisEventLoop::start( void )
+{
+    {
+        Poco::Mutex::ScopedLock lock( _taskMutex );
+        if ( _running )
+        {
+            return;
+        }
+        _running = true;
+    }
+    _tickTime = _now();
+    _thread.start( __onRun, this );
+}
+
+void CRedisEventLoop::stop( void )
+{
+    {
+        Poco::Mutex::ScopedLock lock( _taskMutex );
+        if ( !_running )
+        {
+            return;
+        }
+        _running = false;
+    }
+    _wake();
+    _thread.join();
+
+    Poco::Mutex::ScopedLock lock( _taskMutex );
+    _tasks.clear();
+}
+
+bool CRedisEventLoop::inLoop( void ) const
+{
+    return this == t_pLoop;
+}
+
+void CRedisEventLoop::post( const Task &task )
+{
+    bool wake = false;
+    {
+        Poco::Mutex::ScopedLock lock( _taskMutex );
+        _tasks.push_back( task );
+        // the loop is woken up once for the tasks posted before it takes them.
+        wake = ( 1 == _tasks.size() );
+    }
+    if ( wake )
+    {
+        _wake();
+    }
+}
+
+void CRedisEventLoop::invoke( const Task &task )
+{
+    bool running = false;
+    {
+        Poco::Mutex::ScopedLock lock( _taskMutex );
+        running = _running;
+    }
+    if ( !running || inLoop() )
+    {
+        task();
+        return;
+    }
+
+    Poco::Event done;
+    std::exception_ptr error;
+    post( [&task, &done, &error]()
+    {
+        try
+        {
+            task();
+        }catch ( ... )
+        {
+            error = std::current_exception();
+        }
+        done.set();
+    } );
+    done.wait();
+    if ( error )
+    {
+        std::rethrow_exception( error );
+    }
+}
+
+void CRedisEventLoop::add( int fd, uint32_t events, Handler *pHandler )
+{
+    struct epoll_event ev;
+    memset( &ev, 0, sizeof( ev ) );
+    ev.events = events;
+    ev.data.fd = fd;
+    if ( ::epoll_ctl( _epollFd, EPOLL_CTL_ADD, fd, &ev ) < 0 )
+    {
+        throw ConnectErr( string( "epoll_ctl exception: " ) + strerror( errno ) );
+    }
+    _handlers[fd] = pHandler;
+}
+
+void CRedisEventLoop::modify( int fd, uint32_t events )
+{
+    struct epoll_event ev;
+    memset( &ev, 0, sizeof( ev ) );
+    ev.events = events;
+    ev.data.fd = fd;
+    if ( ::epoll_ctl( _epollFd, EPOLL_CTL_MOD, fd, &ev ) < 0 )
+    {
+        throw ConnectErr( string( "epoll_ctl exception: " ) + strerror( errno ) );
+    }
+}
+
+void CRedisEventLoop::remove( int fd )
+{
+    ::epoll_ctl( _epollFd, EPOLL_CTL_DEL, fd, NULL );
+    _handlers.erase( fd );
+}
+
+CRedisEventLoop::TimerId CRedisEventLoop::addTimer( int64_t ms, const Task &task )
+{
+    if ( _timers.empty() )
+    {
+        // the wheel does not turn while there is no timer.
+        _tickTime = _now();
+    }
+    // counted from the beginning of the current tick, so it never runs early.
+    int64_t elapsed = _now() - _tickTime + ( ms > 0 ? ms * 1000 : 0 );
+    uint64_t ticks = static_cast<uint64_t>( ( elapsed + TICK_MS * 1000 - 1 ) / ( TICK_MS * 1000 ) );
+    if ( 0 == ticks )
+    {
+        ticks = 1;
+    }
+
+    Timer timer;
+    timer.id = ++_nextTimerId;
+    timer.rounds = ( ticks - 1 ) / WHEEL_SLOTS;
+    timer.task = task;
+
+    TimerPos pos;
+    pos.slot = ( _slot + ticks ) % WHEEL_SLOTS;
+    pos.it = _wheel[pos.slot].insert( _wheel[pos.slot].end(), timer );
+    _timers[timer.id] = pos;
+    return timer.id;
+}
+
+void CRedisEventLoop::cancelTimer( TimerId id )
+{
+    std::unordered_map<TimerId, TimerPos>::iterator it = _timers.find( id );
+    if ( it != _timers.end() )
+    {
+        _wheel[it->second.slot].erase( it->second.it );
+        _timers.erase( it );
+    }
+}
+
+//----------------------------------------------private----------------------------------------------------
+void CRedisEventLoop::_run( void )
+{
+    t_pLoop = this;
+    std::vector<struct epoll_event> events( MAX_EVENTS );
+    while ( 1 )
+    {
+        {
+            Poco::Mutex::ScopedLock lock( _taskMutex );
+            if ( !_running )
+            {
+                break;
+            }
+        }
+
+        int n = ::epoll_wait( _epollFd, &events[0], MAX_EVENTS, _waitMs() );
+        for ( int i = 0; i < n; ++i )
+        {
+            int fd = events[i].data.fd;
+            if ( fd == _wakeFd )
+            {
+                uint64_t count = 0;
+                ssize_t rd = ::read( _wakeFd, &count, sizeof( count ) );
+                ( void )rd;
+                continue;
+            }
+            // looked up for each event, a handler may remove another one.
+            std::unordered_map<int, Handler*>::iterator it = _handlers.find( fd );
+            if ( it == _handlers.end() )
+            {
+                continue;
+            }
+            try
+            {
+                it->second->onEvent( fd, events[i].events );
+            }catch ( ... )
+            {
+                // a handler must not throw, the loop goes on for the other connections.
+            }
+        }
+
+        _runTasks();
+        _advance();
+    }
+    t_pLoop = NULL;
+}
+
+void CRedisEventLoop::_runTasks( void )
+{
+    std::vector<Task> tasks;
+    {
+        Poco::Mutex::ScopedLock lock( _taskMutex );
+        tasks.swap( _tasks );
+    }
+    for ( size_t i = 0; i < tasks.size(); ++i )
+    {
+        try
+        {
+            tasks[i]();
+        }catch ( ... )
+        {
+        }
+    }
+}
+
+void CRedisEventLoop::_advance( void )
+{
+    int64_t now = _now();
+    std::vector<TimerId> due;
+    while ( !_timers.empty() && _tickTime + TICK_MS * 1000 <= now )
+    {
+        _tickTime += TICK_MS * 1000;
+        _slot = ( _slot + 1 ) % WHEEL_SLOTS;
+
+        due.clear();
+        ListTimer& timers = _wheel[_slot];
+        for ( ListTimer::iterator it = timers.begin(); it != timers.end(); ++it )
+        {
+            if ( 0 == it->rounds )
+            {
+                due.push_back( it->id );
+            }else
+            {
+                --it->rounds;
+            }
+        }
+
+        // a timer may cancel another one due in the same tick.
+        for ( size_t i = 0; i < due.size(); ++i )
+        {
+            std::unordered_map<TimerId, TimerPos>::iterator pos = _timers.find( due[i] );
+            if ( pos == _timers.end() )
+            {
+                continue;
+            }
+            Task task;
+            task.swap( pos->second.it->task );
+            timers.erase( pos->second.it );
+            _timers.erase( pos );
+            try
+            {
+                task();
+            }catch ( ... )
+            {
+            }
+        }
+    }
+}
+
+int CRedisEventLoop::_waitMs( void ) const
+{
+    if ( _timers.empty() )
+    {
+        return -1;
+    }
+    // rounded up, waking before the tick would only wait again.
+    int64_t us = _tickTime + TICK_MS * 1000 - _now();
+    return ( us > 0 ) ? static_cast<int>( ( us + 999 ) / 1000 ) : 0;
+}
+
+void CRedisEventLoop::_wake( void )
+{
+    uint64_t one = 1;
+    ssize_t wr = ::write( _wakeFd, &one, sizeof( one ) );
+    ( void )wr;
+}
+
+int64_t CRedisEventLoop::_now( void )
+{
+    struct timespec ts;
+    ::clock_gettime( CLOCK_MONOTONIC, &ts );
+    return static_cast<int64_t>( ts.tv_sec ) * 1000000 + ts.tv_nsec / 1000;
+}
+
+void CRedisEventLoop::__onRun( void *pVoid )
+{
+    CRedisEventLoop* pLoop = static_cast<CRedisEventLoop*>( pVoid );
+    if ( pLoop )
+    {
+        pLoop->_run();
+    }
+}
@@ -0,0 +1,172 @@
+/**
+ * @file	CRedisEventLoop.h
+ * @brief 事件循环：一个 I/O 线程用 epoll 管理任意多个连接，定时器放在时间轮中。
+ *
+ * 多个 CRedisMultiplexer 可以共用一个事件循环，例如连接 200 个 redis 实例只需一个线程：
+ * CRedisEventLoop loop;
+ * loop.start();
+ * CRedisMultiplexer shard1( &loop ), shard2( &loop );
+ * shard1.connect( "10.0.0.1", 6379 );
+ * shard2.connect( "10.0.0.2", 6379 );
+ */
+
+#ifndef CREDISEVENTLOOP_H
+#define CREDISEVENTLOOP_H
+
+#include <vector>
+#include <list>
+#include <functional>
+#include <unordered_map>
+#include <Poco/Mutex.h>
+#include <Poco/Thread.h>
+#include "redisCommon.h"
+#include "RdException.hpp"
+
+class CRedisEventLoop
+{
+public:
+    typedef std::function<void ( void )> Task;
+    typedef uint64_t TimerId;		///< 0 is never used, it means no timer.
+
+    /**
+     * @brief The Handler class is told when its fd is ready, on the loop thread.
+     */
+    class Handler
+    {
+    public:
+        virtual ~Handler() {}
+
+        /**
+         * @brief onEvent
+         * @param events [in] EPOLLIN, EPOLLOUT, EPOLLERR, EPOLLHUP... It may be stale:
+         * an fd closed and opened again within one epoll_wait() gets the events of the old one.
+         */
+        virtual void onEvent( int fd , uint32_t events ) = 0;
+    };
+
+    enum
+    {
+        TICK_MS = 10,			///< resolution of the timer wheel.
+        WHEEL_SLOTS = 512,		///< one lap is 5.12s, a longer timer waits for more laps.
+        MAX_EVENTS = 128		///< events taken by one epoll_wait().
+    };
+
+    /**
+     * @brief CRedisEventLoop
+     * @warning throw ConnectErr when epoll or eventfd can not be created.
+     */
+    CRedisEventLoop();
+
+    /**
+     * @brief ~CRedisEventLoop stop(). The connections on it must be closed before.
+     */
+    ~CRedisEventLoop();
+
+    /**
+     * @brief start the loop thread, nothing happens when it is running.
+     */
+    void start( void );
+
+    /**
+     * @brief stop the loop thread and wait for it. Tasks not run yet are dropped.
+     * @warning do not call it from the loop thread.
+     */
+    void stop( void );
+
+    /**
+     * @brief inLoop
+     * @return true: called from the loop thread.
+     */
+    bool inLoop( void ) const;
+
+    /**
+     * @brief post run task on the loop thread, from any thread. Tasks run in the order posted.
+     */
+    void post( const Task& task );
+
+    /**
+     * @brief invoke run task on the loop thread and wait until it returns.
+     * Called from the loop thread it runs at once.
+     */
+    void invoke( const Task& task );
+
+    /**
+     * @brief add watch fd, the loop thread only. modify() changes the events watched.
+     * @param events [in] EPOLLIN, EPOLLOUT... level triggered.
+     * @warning throw ConnectErr when epoll_ctl fails.
+     */
+    void add( int fd , uint32_t events , Handler* pHandler );
+    void modify( int fd , uint32_t events );
+
+    /**
+     * @brief remove stop watching fd, call it before closing fd. The loop thread only.
+     */
+    void remove( int fd );
+
+    /**
+     * @brief addTimer run task once after ms, the loop thread only.
+     * Timers are kept in a wheel of WHEEL_SLOTS slots of TICK_MS, adding and cancelling is O(1).
+     * @return the timer, for cancelTimer().
+     */
+    TimerId addTimer( int64_t ms , const Task& task );
+
+    /**
+     * @brief cancelTimer nothing happens when the timer ran already, the loop thread only.
+     */
+    void cancelTimer( TimerId id );
+
+private:
+    DISALLOW_COPY_AND_ASSIGN( CRedisEventLoop );
+
+    struct Timer
+    {
+        TimerId id;
+        uint64_t rounds;		///< laps of the wheel still to wait.
+        Task task;
+    };
+    typedef std::list<Timer> ListTimer;
+
+    struct TimerPos
+    {
+        size_t slot;
+        ListTimer::iterator it;
+    };
+
+    void _run( void );
+    void _runTasks( void );
+
+    /**
+     * @brief _advance turn the wheel to now, run the timers due.
+     */
+    void _advance( void );
+
+    /**
+     * @brief _waitMs how long epoll_wait() may sleep: until the next tick when there are timers.
+     */
+    int _waitMs( void ) const;
+
+    void _wake( void );
+    /**
+     * @brief _now steady clock in us.
+     */
+    static int64_t _now( void );
+    static void __onRun( void* pVoid );
+
+    int _epollFd;
+    int _wakeFd;					///< eventfd, written by post() and stop().
+    Poco::Thread _thread;
+    bool _running;					///< guarded by _taskMutex.
+
+    Poco::Mutex _taskMutex;
+    std::vector<Task> _tasks;		///< posted, not run yet.
+
+    ///< the loop thread only.
+    std::unordered_map<int, Handler*> _handlers;
+    std::vector<ListTimer> _wheel;
+    std::unordered_map<TimerId, TimerPos> _timers;
+    size_t _slot;					///< slot of the current tick.
+    int64_t _tickTime;				///< when the current tick began, us.
+    TimerId _nextTimerId;
+};
+
+#endif // CREDISEVENTLOOP_H
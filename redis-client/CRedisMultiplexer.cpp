@@ -0,0 +1,726 @@
+/**
+ * @file	CRedisMultiplexer.cpp
+ * @brief 多路复用连接：多个线程共享一个 socket，自动合并成管道。
+ */
+
+#include "CRedisMultiplexer.h"
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <algorithm>
+
+CRedisMultiplexer::CRedisMultiplexer( CRedisEventLoop* pLoop ):
+    _pLoop( pLoop ),
+    _pOwnLoop( NULL ),
+    _port( 0 ),
+    _running( false ),
+    _state( STATE_CLOSED ),
+    _fd( -1 ),
+    _connected( false ),
+    _watchingOut( false ),
+    _pConnectDone( NULL ),
+    _pConnectError( NULL ),
+    _iovFirst( 0 ),
+    _inBuf( RECV_BUFFER_SIZE ),
+    _inBegin( 0 ),
+    _inEnd( 0 ),
+    _pReply( NULL ),
+    _timer( 0 )
+{
+    _stats.commands = 0;
+    _stats.writes = 0;
+    _stats.reconnects = 0;
+}
+
+CRedisMultiplexer::~CRedisMultiplexer()
+{
+    close();
+    delete _pOwnLoop;
+}
+
+void CRedisMultiplexer::setTimeout( long seconds, long microseconds )
+{
+    _timeout = Timespan( seconds, microseconds );
+}
+
+void CRedisMultiplexer::connect( const string &host, UInt16 port, const string &password )
+{
+    close();
+    _host = host;
+    _port = port;
+    _password = password;
+    if ( host.empty() || '/' != host[0] )
+    {
+        _address = SocketAddress( host, port );
+    }
+    if ( NULL == _pLoop )
+    {
+        _pOwnLoop = new CRedisEventLoop;
+        _pLoop = _pOwnLoop;
+    }
+    _pLoop->start();
+
+    {
+        Poco::Mutex::ScopedLock lock( _mutex );
+        _running = true;
+    }
+    Poco::Event done;
+    std::exception_ptr error;
+    _pLoop->post( [this, &done, &error]()
+    {
+        _connected = false;
+        _pConnectDone = &done;
+        _pConnectError = &error;
+        _open();
+    } );
+    done.wait();
+    if ( error )
+    {
+        {
+            Poco::Mutex::ScopedLock lock( _mutex );
+            _running = false;
+        }
+        std::rethrow_exception( error );
+    }
+}
+
+void CRedisMultiplexer::close( void )
+{
+    {
+        Poco::Mutex::ScopedLock lock( _mutex );
+        if ( !_running )
+        {
+            return;
+        }
+        _running = false;
+    }
+    // after the commands posted before, nothing of this multiplexer is left in the loop.
+    std::exception_ptr error = std::make_exception_ptr( ConnectErr( "the multiplexer is closed!" ) );
+    _pLoop->invoke( [this, &error]()
+    {
+        _drop( error, true );
+    } );
+}
+
+void CRedisMultiplexer::send( const Command &cmd, const Callback &callback )
+{
+    _send( cmd, callback, NULL );
+}
+
+void CRedisMultiplexer::command( const Command &cmd, CResult &result )
+{
+    Poco::Event done;
+    std::exception_ptr error;
+    _send( cmd, [&done, &error]( CResult&, const std::exception_ptr& err )
+    {
+        error = err;
+        done.set();
+    }, &result );
+    done.wait();
+    if ( error )
+    {
+        std::rethrow_exception( error );
+    }
+}
+
+std::future<CResult> CRedisMultiplexer::commandAsync( const Command &cmd )
+{
+    return _async<CResult>( cmd, []( CResult& reply, std::promise<CResult>& promise )
+    {
+        promise.set_value( std::move( reply ) );
+    } );
+}
+
+bool CRedisMultiplexer::get( const string &key, string &value )
+{
+    Command cmd( CMD_GET );
+    cmd << key;
+    CResult result;
+    command( cmd, result );
+    return _getReply( result, value, "GET" );
+}
+
+void CRedisMultiplexer::set( const string &key, const string &value )
+{
+    Command cmd( CMD_SET );
+    cmd << key << value;
+    CResult result;
+    command( cmd, result );
+    _setReply( result, "SET" );
+}
+
+uint64_t CRedisMultiplexer::del( const string &key )
+{
+    Command cmd( "DEL" );
+    cmd << key;
+    CResult result;
+    command( cmd, result );
+    return _intReply( result, "DEL" );
+}
+
+bool CRedisMultiplexer::hget( const string &key, const string &field, string &value )
+{
+    Command cmd( CMD_HGET );
+    cmd << key << field;
+    CResult result;
+    command( cmd, result );
+    return _getReply( result, value, "HGET" );
+}
+
+uint8_t CRedisMultiplexer::hset( const string &key, const string &field, const string &value )
+{
+    Command cmd( CMD_HSET );
+    cmd << key << field << Command::Ref( value );
+    CResult result;
+    command( cmd, result );
+    return _intReply( result, "HSET" );
+}
+
+std::future<CRedisMultiplexer::Value> CRedisMultiplexer::getAsync( const string &key )
+{
+    Command cmd( CMD_GET );
+    cmd << key;
+    return _async<Value>( cmd, []( CResult& reply, std::promise<Value>& promise )
+    {
+        Value value;
+        value.exists = _getReply( reply, value.value, "GET" );
+        promise.set_value( std::move( value ) );
+    } );
+}
+
+std::future<void> CRedisMultiplexer::setAsync( const string &key, const string &value )
+{
+    Command cmd( CMD_SET );
+    cmd << key << value;
+    return _async<void>( cmd, []( CResult& reply, std::promise<void>& promise )
+    {
+        _setReply( reply, "SET" );
+        promise.set_value();
+    } );
+}
+
+std::future<uint64_t> CRedisMultiplexer::delAsync( const string &key )
+{
+    Command cmd( "DEL" );
+    cmd << key;
+    return _async<uint64_t>( cmd, []( CResult& reply, std::promise<uint64_t>& promise )
+    {
+        promise.set_value( _intReply( reply, "DEL" ) );
+    } );
+}
+
+std::future<CRedisMultiplexer::Value> CRedisMultiplexer::hgetAsync( const string &key, const string &field )
+{
+    Command cmd( CMD_HGET );
+    cmd << key << field;
+    return _async<Value>( cmd, []( CResult& reply, std::promise<Value>& promise )
+    {
+        Value value;
+        value.exists = _getReply( reply, value.value, "HGET" );
+        promise.set_value( std::move( value ) );
+    } );
+}
+
+std::future<uint8_t> CRedisMultiplexer::hsetAsync( const string &key, const string &field, const string &value )
+{
+    Command cmd( CMD_HSET );
+    // copied: the caller does not wait, value may be gone before it is written.
+    cmd << key << field << value;
+    return _async<uint8_t>( cmd, []( CResult& reply, std::promise<uint8_t>& promise )
+    {
+        promise.set_value( static_cast<uint8_t>( _intReply( reply, "HSET" ) ) );
+    } );
+}
+
+CRedisMultiplexer::Stats CRedisMultiplexer::getStats( void ) const
+{
+    Poco::Mutex::ScopedLock lock( _mutex );
+    return _stats;
+}
+
+//----------------------------------------------private----------------------------------------------------
+void CRedisMultiplexer::_send( const Command &cmd, const Callback &callback, CResult *pResult )
+{
+    Poco::Mutex::ScopedLock lock( _mutex );
+    if ( !_running )
+    {
+        throw ConnectErr( "the multiplexer is not connected!" );
+    }
+    _queue.push_back( Request( cmd, callback, pResult ) );
+    if ( 1 == _queue.size() )
+    {
+        // the loop takes everything queued, it is only told when the queue was empty.
+        _pLoop->post( [this]()
+        {
+            _flush();
+        } );
+    }
+}
+
+void CRedisMultiplexer::onEvent( int fd, uint32_t events )
+{
+    if ( fd != _fd )
+    {
+        return;
+    }
+    if ( STATE_CONNECTING == _state )
+    {
+        int err = 0;
+        socklen_t len = sizeof( err );
+        if ( ::getsockopt( _fd, SOL_SOCKET, SO_ERROR, &err, &len ) < 0 )
+        {
+            err = errno;
+        }
+        if ( 0 == err )
+        {
+            _onConnected();
+        }else if ( EINPROGRESS != err )
+        {
+            _drop( std::make_exception_ptr( ConnectErr( string( "connect exception: " ) + strerror( err ) ) ), true );
+        }
+        return;
+    }
+
+    if ( events & ( EPOLLIN | EPOLLERR | EPOLLHUP ) )
+    {
+        _read();
+    }
+    if ( STATE_CONNECTED == _state && ( events & EPOLLOUT ) && !_writing.empty() )
+    {
+        if ( _write() )
+        {
+            _flush();
+        }
+    }
+}
+
+void CRedisMultiplexer::_open( void )
+{
+    _state = STATE_CONNECTING;
+    if ( !_password.empty() )
+    {
+        // queued in front of the batch, a wrong password fails the commands with NOAUTH.
+        Command auth( "AUTH" );
+        auth << _password;
+        Poco::Mutex::ScopedLock lock( _mutex );
+        _queue.push_front( Request( auth, Callback(), NULL ) );
+    }
+
+    try
+    {
+        struct sockaddr_un unixAddr;
+        const struct sockaddr* pAddr = _address.addr();
+        socklen_t len = _address.length();
+        if ( !_host.empty() && '/' == _host[0] )
+        {
+            CRedisTransport::unixAddress( _host, unixAddr );
+            pAddr = reinterpret_cast<const struct sockaddr*>( &unixAddr );
+            len = sizeof( unixAddr );
+        }
+
+        bool connected = false;
+        _fd = CRedisTransport::startConnect( pAddr, len, connected );
+        if ( connected )
+        {
+            _pLoop->add( _fd, EPOLLIN, this );
+            _onConnected();
+            return;
+        }
+        _pLoop->add( _fd, EPOLLOUT, this );
+        _watchingOut = true;
+        if ( _timeout.totalMilliseconds() > 0 )
+        {
+            _timer = _pLoop->addTimer( _timeout.totalMilliseconds(), [this]()
+            {
+                _timer = 0;
+                _drop( std::make_exception_ptr( ConnectErr( "connect timeout!" ) ), true );
+            } );
+        }
+    }catch ( ... )
+    {
+        _drop( std::current_exception(), true );
+    }
+}
+
+void CRedisMultiplexer::_onConnected( void )
+{
+    if ( _timer )
+    {
+        _pLoop->cancelTimer( _timer );
+        _timer = 0;
+    }
+    _state = STATE_CONNECTED;
+    _watchOut( false );
+    if ( _connected )
+    {
+        Poco::Mutex::ScopedLock lock( _mutex );
+        ++_stats.reconnects;
+    }
+    _connected = true;
+    if ( _pConnectDone )
+    {
+        _pConnectDone->set();
+        _pConnectDone = NULL;
+        _pConnectError = NULL;
+    }
+    _flush();
+}
+
+void CRedisMultiplexer::_drop( const std::exception_ptr &error, bool failQueued )
+{
+    if ( _timer )
+    {
+        _pLoop->cancelTimer( _timer );
+        _timer = 0;
+    }
+    if ( _fd >= 0 )
+    {
+        _pLoop->remove( _fd );
+        ::close( _fd );
+        _fd = -1;
+    }
+    _state = STATE_CLOSED;
+    _watchingOut = false;
+    _writing.clear();
+    _iov.clear();
+    _iovFirst = 0;
+    _inBegin = 0;
+    _inEnd = 0;
+    _pReply = NULL;
+
+    QueWaiter inflight;
+    inflight.swap( _inflight );
+    QueRequest queued;
+    {
+        Poco::Mutex::ScopedLock lock( _mutex );
+        if ( failQueued )
+        {
+            queued.swap( _queue );
+        }
+        if ( _running && !_queue.empty() )
+        {
+            // the commands queued meanwhile set the connection up again, not from inside _drop().
+            // posted under the lock: a close() after it is run after it.
+            _pLoop->post( [this]()
+            {
+                _flush();
+            } );
+        }
+    }
+    if ( _pConnectDone )
+    {
+        *_pConnectError = error;
+        _pConnectDone->set();
+        _pConnectDone = NULL;
+        _pConnectError = NULL;
+    }
+    _fail( inflight, error );
+    _fail( queued, error );
+}
+
+void CRedisMultiplexer::_flush( void )
+{
+    if ( STATE_CLOSED == _state )
+    {
+        bool open = false;
+        {
+            Poco::Mutex::ScopedLock lock( _mutex );
+            open = _running && !_queue.empty();
+        }
+        if ( open )
+        {
+            _open();
+        }
+        return;
+    }
+
+    while ( STATE_CONNECTED == _state && _writing.empty() )
+    {
+        {
+            Poco::Mutex::ScopedLock lock( _mutex );
+            if ( _queue.empty() )
+            {
+                break;
+            }
+            _writing.swap( _queue );
+            ++_stats.writes;
+            _stats.commands += _writing.size();
+        }
+
+        bool idle = _inflight.empty();
+        _iov.clear();
+        _iovFirst = 0;
+        for ( QueRequest::iterator it = _writing.begin(); it != _writing.end(); ++it )
+        {
+            it->cmd.makeIovec( _iov );
+            // only what the reader needs, the commands stay in _writing until they are written.
+            _inflight.push_back( Waiter() );
+            _inflight.back().callback.swap( it->waiter.callback );
+            _inflight.back().pResult = it->waiter.pResult;
+        }
+        if ( idle )
+        {
+            _armTimer();
+        }
+        if ( !_write() )
+        {
+            break;
+        }
+    }
+}
+
+bool CRedisMultiplexer::_write( void )
+{
+    while ( _iovFirst < _iov.size() )
+    {
+        struct msghdr msg;
+        memset( &msg, 0, sizeof( msg ) );
+        msg.msg_iov = &_iov[_iovFirst];
+        msg.msg_iovlen = std::min<size_t>( _iov.size() - _iovFirst, IOV_MAX );
+
+        ssize_t n = ::sendmsg( _fd, &msg, MSG_NOSIGNAL );
+        if ( n < 0 )
+        {
+            if ( EINTR == errno )
+            {
+                continue;
+            }
+            if ( EAGAIN == errno || EWOULDBLOCK == errno )
+            {
+                _watchOut( true );
+                return false;
+            }
+            _drop( std::make_exception_ptr( ConnectErr( string( "sendmsg exception: " ) + strerror( errno ) ) ), false );
+            return false;
+        }
+
+        // skip the buffers sent completely, continue a partial one from where it stopped.
+        size_t sd = static_cast<size_t>( n );
+        while ( _iovFirst < _iov.size() && sd >= _iov[_iovFirst].iov_len )
+        {
+            sd -= _iov[_iovFirst].iov_len;
+            ++_iovFirst;
+        }
+        if ( sd > 0 )
+        {
+            _iov[_iovFirst].iov_base = static_cast<char*>( _iov[_iovFirst].iov_base ) + sd;
+            _iov[_iovFirst].iov_len -= sd;
+        }
+    }
+    _writing.clear();
+    _iov.clear();
+    _iovFirst = 0;
+    _watchOut( false );
+    return true;
+}
+
+void CRedisMultiplexer::_read( void )
+{
+    if ( _inEnd == _inBuf.size() )
+    {
+        if ( _inBegin > 0 )
+        {
+            memmove( &_inBuf[0], &_inBuf[_inBegin], _inEnd - _inBegin );
+            _inEnd -= _inBegin;
+            _inBegin = 0;
+        }else
+        {
+            _inBuf.resize( _inBuf.size() * 2 );
+        }
+    }
+
+    ssize_t n = 0;
+    do
+    {
+        n = ::recv( _fd, &_inBuf[_inEnd], _inBuf.size() - _inEnd, 0 );
+    }while ( n < 0 && EINTR == errno );
+
+    if ( 0 == n )
+    {
+        _drop( std::make_exception_ptr( ConnectErr( "socket is disconnect!" ) ), false );
+        return;
+    }
+    if ( n < 0 )
+    {
+        if ( EAGAIN != errno && EWOULDBLOCK != errno )
+        {
+            _drop( std::make_exception_ptr( ConnectErr( string( "recv exception: " ) + strerror( errno ) ) ), false );
+        }
+        return;
+    }
+    _inEnd += n;
+
+    try
+    {
+        while ( _inBegin < _inEnd )
+        {
+            if ( _inflight.empty() )
+            {
+                throw ProtocolErr( "a reply came, no command waits for it!" );
+            }
+            if ( NULL == _pReply )
+            {
+                _pReply = ( NULL != _inflight.front().pResult ) ? _inflight.front().pResult : &_temp;
+                _parser.reset( *_pReply );
+            }
+
+            size_t consumed = 0;
+            CRedisParser::Status status = _parser.feed( &_inBuf[_inBegin], _inEnd - _inBegin, consumed );
+            _inBegin += consumed;
+            if ( CRedisParser::COMPLETE != status )
+            {
+                break;
+            }
+
+            Waiter waiter;
+            waiter.callback.swap( _inflight.front().callback );
+            _inflight.pop_front();
+            _armTimer();
+            CResult* pReply = _pReply;
+            _pReply = NULL;
+            _complete( waiter, *pReply, std::exception_ptr() );
+            if ( STATE_CONNECTED != _state )
+            {
+                // closed by the callback.
+                return;
+            }
+        }
+    }catch ( ... )
+    {
+        _drop( std::current_exception(), false );
+        return;
+    }
+    if ( _inBegin == _inEnd )
+    {
+        _inBegin = 0;
+        _inEnd = 0;
+    }
+}
+
+void CRedisMultiplexer::_watchOut( bool on )
+{
+    if ( on != _watchingOut && _fd >= 0 )
+    {
+        _pLoop->modify( _fd, on ? ( EPOLLIN | EPOLLOUT ) : EPOLLIN );
+        _watchingOut = on;
+    }
+}
+
+void CRedisMultiplexer::_armTimer( void )
+{
+    if ( _timer )
+    {
+        _pLoop->cancelTimer( _timer );
+        _timer = 0;
+    }
+    if ( !_inflight.empty() && _timeout.totalMilliseconds() > 0 )
+    {
+        _timer = _pLoop->addTimer( _timeout.totalMilliseconds(), [this]()
+        {
+            _timer = 0;
+            _drop( std::make_exception_ptr( ConnectErr( "recv timeout!" ) ), false );
+        } );
+    }
+}
+
+template <typename T, typename Convert>
+std::future<T> CRedisMultiplexer::_async( const Command &cmd, const Convert &convert )
+{
+    // std::function copies the callback, so the promise is shared.
+    std::shared_ptr< std::promise<T> > pPromise = std::make_shared< std::promise<T> >();
+    std::future<T> future = pPromise->get_future();
+    send( cmd, [pPromise, convert]( CResult& reply, const std::exception_ptr& error )
+    {
+        if ( error )
+        {
+            pPromise->set_exception( error );
+            return;
+        }
+        try
+        {
+            convert( reply, *pPromise );
+        }catch ( ... )
+        {
+            pPromise->set_exception( std::current_exception() );
+        }
+    } );
+    return future;
+}
+
+bool CRedisMultiplexer::_getReply( CResult &result, string &value, const char *what )
+{
+    switch ( result.getType() )
+    {
+    case REDIS_REPLY_NIL:
+        return false;
+    case REDIS_REPLY_STRING:
+        value.swap( result );
+        return true;
+    case REDIS_REPLY_ERROR:
+        throw ReplyErr( result.getErrorString() );
+    default:
+        throw ProtocolErr( string( what ) + ": data recved is not string" );
+    }
+}
+
+void CRedisMultiplexer::_setReply( CResult &result, const char *what )
+{
+    if ( REDIS_REPLY_ERROR == result.getType() )
+    {
+        throw ReplyErr( result.getErrorString() );
+    }
+    if ( REDIS_REPLY_STATUS != result.getType() || "OK" != result.getStatus() )
+    {
+        throw ProtocolErr( string( what ) + ": data recved is not status" );
+    }
+}
+
+int64_t CRedisMultiplexer::_intReply( CResult &result, const char *what )
+{
+    if ( REDIS_REPLY_ERROR == result.getType() )
+    {
+        throw ReplyErr( result.getErrorString() );
+    }
+    if ( REDIS_REPLY_INTEGERER != result.getType() )
+    {
+        throw ProtocolErr( string( what ) + ": data recved is not intergerer" );
+    }
+    return result.getInt();
+}
+
+void CRedisMultiplexer::_fail( QueWaiter &waiters, const std::exception_ptr &error )
+{
+    for ( QueWaiter::iterator it = waiters.begin(); it != waiters.end(); ++it )
+    {
+        CResult nil;
+        _complete( *it, nil, error );
+    }
+}
+
+void CRedisMultiplexer::_fail( QueRequest &requests, const std::exception_ptr &error )
+{
+    for ( QueRequest::iterator it = requests.begin(); it != requests.end(); ++it )
+    {
+        CResult nil;
+        _complete( it->waiter, nil, error );
+    }
+}
+
+void CRedisMultiplexer::_complete( Waiter &waiter, CResult &reply, const std::exception_ptr &error )
+{
+    if ( !waiter.callback )
+    {
+        return;
+    }
+    try
+    {
+        waiter.callback( reply, error );
+    }catch ( ... )
+    {
+        // a callback must not throw, the replies after it would be lost.
+    }
+}
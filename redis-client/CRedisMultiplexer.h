@@ -0,0 +1,287 @@
+/**
+ * @file	CRedisMultiplexer.h
+ * @brief 多路复用连接：多个线程共享一个 socket，自动合并成管道。
+ *
+ * 任意线程把指令放入队列；事件循环把队列中积累的全部指令用一次 sendmsg() 写出，
+ * 按 FIFO 顺序把回复交给等待的调用者。RTT 内到达的请求共用一次写和一次 RTT。
+ * 连接运行在 CRedisEventLoop 上：默认自己一个，也可以多个连接共用一个。
+ *
+ * CRedisMultiplexer mux;
+ * mux.connect( "127.0.0.1", 6379 );
+ * // any thread:
+ * Command cmd( "GET" ); cmd << key;
+ * CResult result;
+ * mux.command( cmd, result );
+ * // or issue independent commands first, then wait for them:
+ * std::future<CRedisMultiplexer::Value> a = mux.getAsync( "a" );
+ * std::future<CRedisMultiplexer::Value> b = mux.getAsync( "b" );
+ * CRedisMultiplexer::Value valueA = a.get(), valueB = b.get();
+ * if ( valueA.exists && valueB.exists ) ...
+ */
+
+#ifndef CREDISMULTIPLEXER_H
+#define CREDISMULTIPLEXER_H
+
+#include <deque>
+#include <vector>
+#include <functional>
+#include <exception>
+#include <future>
+#include <memory>
+#include <Poco/Mutex.h>
+#include <Poco/Event.h>
+#include "CRedisClient.h"
+#include "CRedisEventLoop.h"
+
+class CRedisMultiplexer : private CRedisEventLoop::Handler
+{
+public:
+    /**
+     * @brief Callback receives the reply of a command sent by send().
+     * @param reply [in] the reply, an error reply is REDIS_REPLY_ERROR, it is not thrown.
+     * It may be changed, eg: swapped out, it is dropped after the callback.
+     * @param error [in] not null when the connection failed before the reply came,
+     * reply is NIL then. std::rethrow_exception() it to get a ConnectErr...
+     */
+    typedef std::function<void ( CResult& reply, const std::exception_ptr& error )> Callback;
+
+    struct Stats
+    {
+        uint64_t commands;		///< commands sent.
+        uint64_t writes;		///< batches written, commands / writes is the pipelining achieved.
+        uint64_t reconnects;	///< connections set up again after a failure.
+    };
+
+    /**
+     * @brief The Value struct is what getAsync() and hgetAsync() give.
+     */
+    struct Value
+    {
+        Value(): exists( false ) {}
+        bool exists;			///< false: the key or the field does not exist.
+        string value;
+    };
+
+    /**
+     * @brief CRedisMultiplexer
+     * @param pLoop [in] the event loop the connection runs on, it must outlive the multiplexer.
+     * NULL: connect() starts a loop of its own.
+     */
+    explicit CRedisMultiplexer( CRedisEventLoop* pLoop = NULL );
+
+    /**
+     * @brief ~CRedisMultiplexer close(), see it.
+     */
+    ~CRedisMultiplexer();
+
+    /**
+     * @brief setTimeout the connect and send timeout, and how long the oldest command waits
+     * for its reply. 0: no timeout, the default. Call it before connect().
+     * When a reply times out the connection is dropped, all the commands in flight fail.
+     */
+    void setTimeout( long seconds , long microseconds );
+
+    /**
+     * @brief connect to redis, wait until the connection is set up.
+     * After a failure the connection is set up again by the next command.
+     * @param host [in] ip, or the path of a unix socket, see CRedisClient::setAddress().
+     * @param password [in] sent with AUTH each time the connection is set up, empty: none.
+     * @warning throw ConnectErr when it can not connect.
+     */
+    void connect( const string& host , UInt16 port = 6379 , const string& password = "" );
+
+    /**
+     * @brief close the connection. Commands not answered yet fail with ConnectErr.
+     * Do not call it from a callback.
+     */
+    void close( void );
+
+    /**
+     * @brief send queue a copy of cmd, it is written with the others queued at the same time.
+     * @param callback [in] called on the loop thread, in the order the commands were sent.
+     * It must not block for long, it holds the replies coming after it. It must not throw.
+     * An empty callback drops the reply.
+     * @warning buffers referred by Command::Ref must stay alive until the callback is called.
+     * throw ConnectErr when the multiplexer is not connected.
+     */
+    void send( const Command& cmd , const Callback& callback );
+
+    /**
+     * @brief command send cmd and wait for its reply, from any thread.
+     * @param result [out] the reply, an error reply is stored as REDIS_REPLY_ERROR.
+     * @warning throw ConnectErr when the connection fails or the reply times out.
+     */
+    void command( const Command& cmd , CResult& result );
+
+    /**
+     * @brief commandAsync send cmd without waiting, the future gets its reply. Commands issued
+     * one after another are written together and answered in one RTT.
+     * std::future has no continuation, use send() to run code when the reply comes.
+     * @return future.get() returns the reply, an error reply is stored as REDIS_REPLY_ERROR.
+     * It throws ConnectErr when the connection fails or the reply times out.
+     * @warning like send(): buffers referred by Command::Ref must stay alive until the future
+     * is ready. throw ConnectErr when the multiplexer is not connected.
+     */
+    std::future<CResult> commandAsync( const Command& cmd );
+
+    /**
+     * @brief get
+     * @return false: the key does not exist.
+     * @warning throw ReplyErr on an error reply, like CRedisClient.
+     */
+    bool get( const string& key , string& value );
+    void set( const string& key , const string& value );
+    uint64_t del( const string& key );
+    bool hget( const string& key , const string& field , string& value );
+    uint8_t hset( const string& key , const string& field , const string& value );
+
+    /**
+     * @brief getAsync get() without waiting, future.get() gives what get() returns, or throws what it throws.
+     * So do the other xxxAsync().
+     * @return the value lives in the future, nothing is written to the caller's memory later.
+     */
+    std::future<Value> getAsync( const string& key );
+    std::future<void> setAsync( const string& key , const string& value );
+    std::future<uint64_t> delAsync( const string& key );
+    std::future<Value> hgetAsync( const string& key , const string& field );
+    std::future<uint8_t> hsetAsync( const string& key , const string& field , const string& value );
+
+    Stats getStats( void ) const;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN( CRedisMultiplexer );
+    friend class CRedisCoClient;
+
+    ///< who waits for a reply.
+    struct Waiter
+    {
+        Callback callback;
+        CResult* pResult;		///< where the reply is parsed, NULL: into a temporary.
+    };
+    typedef std::deque<Waiter> QueWaiter;
+
+    ///< a command not written yet.
+    struct Request
+    {
+        Request( const Command& cmd, const Callback& callback, CResult* pResult ):
+            cmd( cmd )
+        {
+            waiter.callback = callback;
+            waiter.pResult = pResult;
+        }
+
+        Command cmd;
+        Waiter waiter;
+    };
+    typedef std::deque<Request> QueRequest;
+
+    enum State
+    {
+        STATE_CLOSED,
+        STATE_CONNECTING,		///< a non-blocking connect is in progress.
+        STATE_CONNECTED
+    };
+
+    enum
+    {
+        RECV_BUFFER_SIZE = 16 * 1024	///< initial size of _inBuf, it grows for a longer reply.
+    };
+
+    void _send( const Command& cmd , const Callback& callback , CResult* pResult );
+
+    /**
+     * @brief onEvent the socket is ready. It and the methods below run on the loop thread.
+     */
+    void onEvent( int fd , uint32_t events );
+
+    /**
+     * @brief _open start a non-blocking connect, queue AUTH first when there is a password.
+     */
+    void _open( void );
+    void _onConnected( void );
+
+    /**
+     * @brief _drop close the connection, the commands in flight fail with error.
+     * @param failQueued [in] fail the commands not written too. Else they set the connection up again.
+     */
+    void _drop( const std::exception_ptr& error , bool failQueued );
+
+    /**
+     * @brief _flush take the commands queued and write them, when nothing is being written.
+     */
+    void _flush( void );
+
+    /**
+     * @brief _write write _iov until it is all sent or the socket is full.
+     * @return true: all written.
+     */
+    bool _write( void );
+    void _read( void );
+
+    /**
+     * @brief _watchOut watch EPOLLOUT too while a batch is partly written.
+     */
+    void _watchOut( bool on );
+
+    /**
+     * @brief _armTimer restart the timeout of the oldest command in flight.
+     */
+    void _armTimer( void );
+
+    /**
+     * @brief _fail hand error to the callbacks of waiters.
+     */
+    static void _fail( QueWaiter& waiters , const std::exception_ptr& error );
+    static void _fail( QueRequest& requests , const std::exception_ptr& error );
+
+    static void _complete( Waiter& waiter , CResult& reply , const std::exception_ptr& error );
+
+    /**
+     * @brief _async send cmd, convert( reply, promise ) sets the value of the future.
+     * An exception thrown by convert goes to the future.
+     */
+    template <typename T, typename Convert>
+    std::future<T> _async( const Command& cmd , const Convert& convert );
+
+    /**
+     * @brief _getReply _setReply _intReply check a reply the way CRedisClient does.
+     * @warning throw ReplyErr on an error reply, ProtocolErr on an unexpected type.
+     */
+    static bool _getReply( CResult& result , string& value , const char* what );
+    static void _setReply( CResult& result , const char* what );
+    static int64_t _intReply( CResult& result , const char* what );
+
+    CRedisEventLoop* _pLoop;
+    CRedisEventLoop* _pOwnLoop;		///< started by connect() when no loop is given.
+    string _host;
+    UInt16 _port;
+    string _password;
+    Timespan _timeout;
+    SocketAddress _address;			///< resolved by connect(), the loop does not wait for DNS.
+
+    mutable Poco::Mutex _mutex;		///< guards the 3 below, they are used by any thread.
+    QueRequest _queue;				///< commands not written yet.
+    bool _running;
+    Stats _stats;
+
+    ///< the loop thread only.
+    State _state;
+    int _fd;
+    bool _connected;				///< connected once, a new connection is a reconnect.
+    bool _watchingOut;
+    Poco::Event* _pConnectDone;		///< set when connect() waits.
+    std::exception_ptr* _pConnectError;
+    QueRequest _writing;			///< the batch being written, _iov refers to it.
+    Command::VecIovec _iov;
+    size_t _iovFirst;				///< buffers before it are written.
+    QueWaiter _inflight;			///< commands written, waiting for their replies in order.
+    std::vector<char> _inBuf;
+    size_t _inBegin;				///< received bytes not parsed yet are [_inBegin, _inEnd).
+    size_t _inEnd;
+    CRedisParser _parser;
+    CResult* _pReply;				///< where the reply being parsed goes, NULL: none yet.
+    CResult _temp;					///< for a waiter without pResult.
+    CRedisEventLoop::TimerId _timer;	///< connect timeout, or that of the oldest reply.
+};
+
+#endif // CREDISMULTIPLEXER_H
@@ -0,0 +1,585 @@
+/**
+ * @file	CRedisParser.cpp
+ * @brief 可断点续传的 RESP 解析器：逐段喂入字节，不阻塞、不递归，嵌套数组用显式栈处理。
+ */
+
+#include "CRedisParser.h"
+#include "RdException.hpp"
+#include "RdNumeric.h"
+#include <string.h>
+#include <algorithm>
+
+const char CRedisParser::PREFIX_REPLY_STATUS;
+const char CRedisParser::PREFIX_REPLY_ERR;
+const char CRedisParser::PREFIX_REPLY_INT;
+const char CRedisParser::PREFIX_BULK_REPLY;
+const char CRedisParser::PREFIX_MULTI_BULK_REPLY;
+const char CRedisParser::PREFIX_REPLY_DOUBLE;
+const char CRedisParser::PREFIX_REPLY_BOOL;
+const char CRedisParser::PREFIX_REPLY_BIGNUM;
+const char CRedisParser::PREFIX_REPLY_NULL;
+const char CRedisParser::PREFIX_VERBATIM_REPLY;
+const char CRedisParser::PREFIX_BLOB_ERR_REPLY;
+const char CRedisParser::PREFIX_MAP_REPLY;
+const char CRedisParser::PREFIX_SET_REPLY;
+const char CRedisParser::PREFIX_PUSH_REPLY;
+const char CRedisParser::PREFIX_ATTRIBUTE_REPLY;
+
+CRedisParser::CRedisParser():
+    _pResult( NULL ),
+    _attrDepth( 0 ),
+    _pHandler( NULL ),
+    _state( STATE_DONE ),
+    _pBulk( NULL ),
+    _bulkType( PREFIX_BULK_REPLY ),
+    _bulkSize( 0 ),
+    _bulkFilled( 0 ),
+    _crlfLeft( 0 ),
+    _maxSize( 0 ),
+    _size( 0 )
+{
+}
+
+CRedisParser::~CRedisParser()
+{
+}
+
+void CRedisParser::reset( CResult &result )
+{
+    result.clear();
+    _pResult = &result;
+    _pHandler = NULL;
+    _begin();
+}
+
+void CRedisParser::reset( CRedisReplyHandler &handler )
+{
+    _pResult = NULL;
+    _pHandler = &handler;
+    _begin();
+}
+
+CRedisParser::Status CRedisParser::feed( const char *data, size_t len, size_t &consumed )
+{
+    consumed = 0;
+    while ( STATE_DONE != _state && STATE_ABORTED != _state )
+    {
+        const char* p = data + consumed;
+        size_t avail = len - consumed;
+        if ( 0 == avail )
+        {
+            return NEED_MORE;
+        }
+
+        switch ( _state )
+        {
+        case STATE_LINE:
+        {
+            const char* pLF = static_cast<const char*>( memchr( p, '\n', avail ) );
+            if ( NULL == pLF )
+            {
+                _addSize( avail );
+                _line.append( p, avail );
+                consumed = len;
+                return NEED_MORE;
+            }
+
+            size_t n = pLF - p;
+            _addSize( n + 1 );
+            consumed += n + 1;
+            if ( _line.empty() )
+            {
+                _parseLine( p, n );
+            }else
+            {
+                _line.append( p, n );
+                _parseLine( _line.data(), _line.size() );
+                _line.clear();
+            }
+            break;
+        }
+        case STATE_BULK:
+        {
+            //------a handler gets a bulk string that is all here in place, without copying it.
+            if ( NULL == _pBulk && avail >= _bulkSize )
+            {
+                consumed += _bulkSize;
+                _bulkFilled = _bulkSize;
+                _bulkDone( p );
+                break;
+            }
+
+            char* pDest = NULL;
+            size_t n = std::min( avail, bulkBuffer( pDest ) );
+            memcpy( pDest, p, n );
+            consumed += n;
+            bulkFilled( n );
+            break;
+        }
+        case STATE_BULK_CRLF:
+            if ( "\r\n"[2 - _crlfLeft] != *p )
+            {
+                throw ProtocolErr( "bulk string is not ended with CRLF" );
+            }
+            ++consumed;
+            if ( 0 == --_crlfLeft )
+            {
+                _pBulk = NULL;
+                _state = STATE_LINE;
+                _valueDone();
+            }
+            break;
+        default:
+            break;
+        }
+    }
+    return ( STATE_DONE == _state ) ? COMPLETE : ABORTED;
+}
+
+size_t CRedisParser::bulkLeft( void ) const
+{
+    return ( STATE_BULK == _state ) ? _bulkSize - _bulkFilled : 0;
+}
+
+size_t CRedisParser::bulkBuffer( char *&pDest )
+{
+    if ( STATE_BULK != _state )
+    {
+        return 0;
+    }
+    if ( NULL == _pBulk )
+    {
+        _scratch.resize( _bulkSize );
+        _pBulk = &_scratch;
+    }
+    pDest = &( *_pBulk )[_bulkFilled];
+    return _bulkSize - _bulkFilled;
+}
+
+bool CRedisParser::bulkFilled( size_t n )
+{
+    _bulkFilled += n;
+    if ( _bulkFilled == _bulkSize )
+    {
+        _bulkDone( ( NULL != _pBulk ) ? _pBulk->data() : "" );
+    }
+    return STATE_ABORTED != _state;
+}
+
+size_t CRedisParser::depth( void ) const
+{
+    return _stack.size();
+}
+
+void CRedisParser::setMaxSize( uint64_t maxSize )
+{
+    _maxSize = maxSize;
+}
+
+uint64_t CRedisParser::getMaxSize( void ) const
+{
+    return _maxSize;
+}
+
+const CResult &CRedisParser::attribute( void ) const
+{
+    return _attribute;
+}
+
+int64_t CRedisParser::parseLength( const char *data, size_t len )
+{
+    int64_t value = 0;
+    if ( !RdNumeric::parseInt( data, len, value ) || value < -1 )
+    {
+        throw ProtocolErr( "invalid length: " + string( data, len ) );
+    }
+    return value;
+}
+
+//----------------------------------------------private----------------------------------------------------
+void CRedisParser::_begin( void )
+{
+    _stack.clear();
+    _attribute.clear();
+    _attrDepth = 0;
+    _state = STATE_LINE;
+    _line.clear();
+    _pBulk = NULL;
+    _bulkSize = 0;
+    _bulkFilled = 0;
+    _crlfLeft = 0;
+    _size = 0;
+    if ( _scratch.capacity() > MAX_SCRATCH_KEEP )
+    {
+        string().swap( _scratch );
+    }
+}
+
+void CRedisParser::_parseLine( const char *line, size_t len )
+{
+    if ( len < 2 || '\r' != line[len - 1] )
+    {
+        throw ProtocolErr( "line is not ended with CRLF" );
+    }
+    const char* p = line + 1;
+    size_t n = len - 2;
+
+    if ( PREFIX_ATTRIBUTE_REPLY == line[0] )
+    {
+        _beginAttribute( parseLength( p, n ) );
+        return;
+    }
+    if ( _handling() )
+    {
+        _handleLine( line[0], p, n );
+        return;
+    }
+
+    CResult* node = _nextNode();
+    switch ( line[0] )
+    {
+    case PREFIX_REPLY_BOOL:
+        _parseBool( p, n );
+        // fall through
+    case PREFIX_REPLY_INT:
+    case PREFIX_REPLY_STATUS:
+    case PREFIX_REPLY_ERR:
+    case PREFIX_REPLY_DOUBLE:
+    case PREFIX_REPLY_BIGNUM:
+        node->setType( _replyType( line[0] ) );
+        node->std::string::assign( p, n );
+        _valueDone();
+        break;
+    case PREFIX_REPLY_NULL:
+        node->setType( REDIS_REPLY_NIL );
+        _valueDone();
+        break;
+    case PREFIX_BULK_REPLY:
+    case PREFIX_VERBATIM_REPLY:
+    case PREFIX_BLOB_ERR_REPLY:
+    {
+        int64_t size = parseLength( p, n );
+        if ( -1 == size && PREFIX_BULK_REPLY == line[0] )
+        {
+            node->setType( REDIS_REPLY_NIL );
+            _valueDone();
+            break;
+        }
+        _beginBulk( line[0], size );
+        node->setType( _replyType( line[0] ) );
+        node->resize( size );
+        _pBulk = node;
+        bulkFilled( 0 );
+        break;
+    }
+    case PREFIX_MULTI_BULK_REPLY:
+    case PREFIX_MAP_REPLY:
+    case PREFIX_SET_REPLY:
+    case PREFIX_PUSH_REPLY:
+    {
+        //The concept of Null Array exists as well
+        int64_t num = _aggregateSize( line[0], parseLength( p, n ) );
+        if ( -1 == num )
+        {
+            node->setType( REDIS_REPLY_NIL );
+            _valueDone();
+            break;
+        }
+        node->setType( _replyType( line[0] ) );
+        if ( 0 == num )
+        {
+            _valueDone();
+            break;
+        }
+        // a bogus count must not allocate without bound, the vector grows past it if needed.
+        node->reserveElements( static_cast<size_t>( std::min<int64_t>( num, MAX_RESERVE_ELEMENTS ) ) );
+        _stack.push_back( Frame( node, num ) );
+        break;
+    }
+    default:
+        throw ProtocolErr( "unknow type" );
+        break;
+    }
+}
+
+void CRedisParser::_handleLine( char type, const char *data, size_t len )
+{
+    bool ok = true;
+    switch ( type )
+    {
+    case PREFIX_REPLY_INT:
+    {
+        int64_t value = 0;
+        if ( !RdNumeric::parseInt( data, len, value ) )
+        {
+            throw ProtocolErr( "invalid integer: " + string( data, len ) );
+        }
+        ok = _pHandler->onInt( value );
+        break;
+    }
+    case PREFIX_REPLY_DOUBLE:
+    {
+        double value = 0;
+        if ( !RdNumeric::parseDouble( data, len, value ) )
+        {
+            throw ProtocolErr( "invalid double: " + string( data, len ) );
+        }
+        ok = _pHandler->onDouble( value, data, len );
+        break;
+    }
+    case PREFIX_REPLY_BOOL:
+        ok = _pHandler->onBool( _parseBool( data, len ) );
+        break;
+    case PREFIX_REPLY_BIGNUM:
+        ok = _pHandler->onBigNumber( data, len );
+        break;
+    case PREFIX_REPLY_STATUS:
+        ok = _pHandler->onStatus( data, len );
+        break;
+    case PREFIX_REPLY_ERR:
+        ok = _pHandler->onError( data, len );
+        break;
+    case PREFIX_REPLY_NULL:
+        ok = _pHandler->onNil();
+        break;
+    case PREFIX_BULK_REPLY:
+    case PREFIX_VERBATIM_REPLY:
+    case PREFIX_BLOB_ERR_REPLY:
+    {
+        int64_t size = parseLength( data, len );
+        if ( -1 == size && PREFIX_BULK_REPLY == type )
+        {
+            ok = _pHandler->onNil();
+            break;
+        }
+        _beginBulk( type, size );
+        _pBulk = NULL;
+        if ( 0 == size )
+        {
+            bulkFilled( 0 );
+        }
+        return;
+    }
+    case PREFIX_MULTI_BULK_REPLY:
+    case PREFIX_MAP_REPLY:
+    case PREFIX_SET_REPLY:
+    case PREFIX_PUSH_REPLY:
+    {
+        int64_t size = parseLength( data, len );
+        int64_t num = _aggregateSize( type, size );
+        if ( -1 == num )
+        {
+            ok = _pHandler->onNil();
+            break;
+        }
+        switch ( type )
+        {
+        case PREFIX_MAP_REPLY:
+            ok = _pHandler->onMapBegin( size );
+            break;
+        case PREFIX_SET_REPLY:
+            ok = _pHandler->onSetBegin( size );
+            break;
+        case PREFIX_PUSH_REPLY:
+            ok = _pHandler->onPushBegin( size );
+            break;
+        default:
+            ok = _pHandler->onArrayBegin( size );
+            break;
+        }
+        if ( !_handled( ok ) )
+        {
+            return;
+        }
+        if ( 0 == num )
+        {
+            ok = _pHandler->onArrayEnd();
+            break;
+        }
+        _stack.push_back( Frame( NULL, num ) );
+        return;
+    }
+    default:
+        throw ProtocolErr( "unknow type" );
+        break;
+    }
+
+    if ( _handled( ok ) )
+    {
+        _valueDone();
+    }
+}
+
+CResult *CRedisParser::_nextNode( void )
+{
+    if ( _stack.empty() )
+    {
+        return _pResult;
+    }
+    return &_stack.back().node->newElement();
+}
+
+void CRedisParser::_bulkDone( const char *data )
+{
+    _state = STATE_BULK_CRLF;
+    _crlfLeft = 2;
+    if ( !_handling() )
+    {
+        return;
+    }
+
+    switch ( _bulkType )
+    {
+    case PREFIX_VERBATIM_REPLY:
+        if ( _bulkSize < 4 || ':' != data[3] )
+        {
+            throw ProtocolErr( "verbatim string has no format" );
+        }
+        _handled( _pHandler->onVerbatim( data, data + 4, _bulkSize - 4 ) );
+        break;
+    case PREFIX_BLOB_ERR_REPLY:
+        _handled( _pHandler->onError( data, _bulkSize ) );
+        break;
+    default:
+        _handled( _pHandler->onBulk( data, _bulkSize ) );
+        break;
+    }
+}
+
+void CRedisParser::_valueDone( void )
+{
+    while ( !_stack.empty() )
+    {
+        Frame& frame = _stack.back();
+        if ( --frame.left > 0 )
+        {
+            return;
+        }
+        bool attribute = frame.attribute;
+        bool handled = ( NULL == frame.node );
+        _stack.pop_back();
+        if ( attribute )
+        {
+            // not a value itself, the value it describes comes next.
+            --_attrDepth;
+            return;
+        }
+        if ( handled && !_handled( _pHandler->onArrayEnd() ) )
+        {
+            return;
+        }
+    }
+    _state = STATE_DONE;
+}
+
+bool CRedisParser::_handled( bool ok )
+{
+    if ( !ok )
+    {
+        _state = STATE_ABORTED;
+    }
+    return ok;
+}
+
+bool CRedisParser::_handling( void ) const
+{
+    return NULL != _pHandler && 0 == _attrDepth;
+}
+
+void CRedisParser::_beginBulk( char type, int64_t size )
+{
+    if ( size < 0 )
+    {
+        throw ProtocolErr( "invalid length of bulk string" );
+    }
+    _addSize( size + 2 );
+    _bulkType = type;
+    _bulkSize = size;
+    _bulkFilled = 0;
+    _state = STATE_BULK;
+}
+
+void CRedisParser::_beginAttribute( int64_t num )
+{
+    if ( 0 != _attrDepth )
+    {
+        throw ProtocolErr( "attribute in an attribute" );
+    }
+    num = _aggregateSize( PREFIX_MAP_REPLY, num );
+    _attribute.clear();
+    _attribute.setType( REDIS_REPLY_MAP );
+    if ( 0 == num )
+    {
+        return;
+    }
+    _attribute.reserveElements( static_cast<size_t>( std::min<int64_t>( num, MAX_RESERVE_ELEMENTS ) ) );
+    _stack.push_back( Frame( &_attribute, num, true ) );
+    ++_attrDepth;
+}
+
+int64_t CRedisParser::_aggregateSize( char type, int64_t num )
+{
+    if ( -1 == num && PREFIX_MULTI_BULK_REPLY != type )
+    {
+        throw ProtocolErr( "invalid length of aggregate" );
+    }
+    if ( PREFIX_MAP_REPLY == type )
+    {
+        if ( num > INT64_MAX / 2 )
+        {
+            throw ProtocolErr( "invalid length of map" );
+        }
+        num *= 2;
+    }
+    return num;
+}
+
+ReplyType CRedisParser::_replyType( char type )
+{
+    switch ( type )
+    {
+    case PREFIX_REPLY_INT:
+        return REDIS_REPLY_INTEGERER;
+    case PREFIX_REPLY_STATUS:
+        return REDIS_REPLY_STATUS;
+    case PREFIX_REPLY_ERR:
+    case PREFIX_BLOB_ERR_REPLY:
+        return REDIS_REPLY_ERROR;
+    case PREFIX_REPLY_DOUBLE:
+        return REDIS_REPLY_DOUBLE;
+    case PREFIX_REPLY_BOOL:
+        return REDIS_REPLY_BOOL;
+    case PREFIX_REPLY_BIGNUM:
+        return REDIS_REPLY_BIGNUM;
+    case PREFIX_VERBATIM_REPLY:
+        return REDIS_REPLY_VERB;
+    case PREFIX_MULTI_BULK_REPLY:
+        return REDIS_REPLY_ARRAY;
+    case PREFIX_MAP_REPLY:
+        return REDIS_REPLY_MAP;
+    case PREFIX_SET_REPLY:
+        return REDIS_REPLY_SET;
+    case PREFIX_PUSH_REPLY:
+        return REDIS_REPLY_PUSH;
+    default:
+        return REDIS_REPLY_STRING;
+    }
+}
+
+bool CRedisParser::_parseBool( const char *data, size_t len )
+{
+    if ( 1 != len || ( 't' != data[0] && 'f' != data[0] ) )
+    {
+        throw ProtocolErr( "invalid boolean: " + string( data, len ) );
+    }
+    return 't' == data[0];
+}
+
+void CRedisParser::_addSize( uint64_t bytes )
+{
+    _size += bytes;
+    if ( 0 != _maxSize && _size > _maxSize )
+    {
+        throw MaximumErr( "reply is larger than the max size" );
+    }
+}
@@ -0,0 +1,310 @@
+/**
+ * @file	CRedisParser.h
+ * @brief 可断点续传的 RESP 解析器：逐段喂入字节，不阻塞、不递归，嵌套数组用显式栈处理。
+ *
+ * CResult result;
+ * CRedisParser parser;
+ * parser.reset( result );
+ * while ( CRedisParser::NEED_MORE == parser.feed( data, len, consumed ) ) { // read more }
+ *
+ * 也可以 reset( handler )，逐个元素回调，不在内存中构建整个回复。
+ * 同时支持 RESP2 与 RESP3（HELLO 3 之后的 map、set、double、bool、big number、verbatim、
+ * attribute、push 等类型）。
+ */
+
+#ifndef CREDISPARSER_H
+#define CREDISPARSER_H
+
+#include <vector>
+#include "CResult.h"
+
+/**
+ * @brief The CRedisReplyHandler class receives a reply element by element while it is parsed,
+ * so a huge array never has to be held in memory as a whole.
+ * Each method returns false to stop the reply, the rest of it is not parsed.
+ * Pointers passed in are only valid until the method returns.
+ */
+class CRedisReplyHandler
+{
+public:
+    virtual ~CRedisReplyHandler() {}
+
+    /**
+     * @brief onArrayBegin an array of size elements starts, its elements come next.
+     */
+    virtual bool onArrayBegin( int64_t size ) { ( void )size; return true; }
+
+    /**
+     * @brief onMapBegin a map of size pairs starts, keys and values come next in turn.
+     * By default it is handed over as an array of size * 2 elements.
+     */
+    virtual bool onMapBegin( int64_t size ) { return onArrayBegin( size * 2 ); }
+
+    virtual bool onSetBegin( int64_t size ) { return onArrayBegin( size ); }
+
+    /**
+     * @brief onPushBegin out of band data starts, eg: a pub/sub message or an invalidation.
+     */
+    virtual bool onPushBegin( int64_t size ) { return onArrayBegin( size ); }
+
+    /**
+     * @brief onArrayEnd the last element of the innermost array, map, set or push was handed over.
+     */
+    virtual bool onArrayEnd( void ) { return true; }
+
+    /**
+     * @brief onBulk a whole bulk string.
+     */
+    virtual bool onBulk( const char* data, size_t len ) = 0;
+
+    virtual bool onInt( int64_t value ) { ( void )value; return true; }
+
+    /**
+     * @brief onDouble the value and the text it was parsed from, by default the text goes to onBulk().
+     */
+    virtual bool onDouble( double value, const char* data, size_t len ) { ( void )value; return onBulk( data, len ); }
+
+    virtual bool onBool( bool value ) { return onInt( value ? 1 : 0 ); }
+
+    /**
+     * @brief onBigNumber the decimal digits, by default they go to onBulk().
+     */
+    virtual bool onBigNumber( const char* data, size_t len ) { return onBulk( data, len ); }
+
+    /**
+     * @brief onVerbatim a verbatim string, by default the text goes to onBulk().
+     * @param format [in] 3 characters, eg: "txt", not null terminated.
+     */
+    virtual bool onVerbatim( const char* format, const char* data, size_t len ) { ( void )format; return onBulk( data, len ); }
+
+    virtual bool onStatus( const char* data, size_t len ) { ( void )data; ( void )len; return true; }
+
+    /**
+     * @brief onError an error line or a blob error.
+     */
+    virtual bool onError( const char* data, size_t len ) { ( void )data; ( void )len; return true; }
+
+    /**
+     * @brief onNil a NIL bulk string, a NIL array or a RESP3 null.
+     */
+    virtual bool onNil( void ) { return true; }
+};
+
+class CRedisParser
+{
+public:
+    enum Status
+    {
+        NEED_MORE,		///< all the bytes are consumed, the reply is not complete yet.
+        COMPLETE,		///< a whole reply is parsed, bytes after it are not consumed.
+        ABORTED			///< the handler stopped the reply, bytes after the stop are not consumed.
+    };
+
+    CRedisParser();
+    ~CRedisParser();
+
+    /**
+     * @brief reset start parsing a new reply, the state of an unfinished one is dropped.
+     * @param result [out] where the reply is stored, it must outlive the parsing.
+     */
+    void reset( CResult& result );
+
+    /**
+     * @brief reset start parsing a new reply, hand it to handler instead of storing it.
+     * @param handler [in] it must outlive the parsing.
+     */
+    void reset( CRedisReplyHandler& handler );
+
+    /**
+     * @brief feed parse bytes received.
+     * @param data [in] next bytes of the stream.
+     * @param len [in] length of data.
+     * @param consumed [out] the number of bytes used, the rest belongs to the next reply.
+     * @return COMPLETE when the reply is parsed, NEED_MORE when more bytes are needed,
+     * ABORTED when the handler returned false.
+     * @warning throw ProtocolErr when data is not valid RESP. throw MaximumErr when the reply
+     * is larger than setMaxSize().
+     */
+    Status feed( const char* data, size_t len, size_t& consumed );
+
+    /**
+     * @brief bulkLeft
+     * @return the number of bytes of the bulk string being parsed still missing, 0 if none.
+     */
+    size_t bulkLeft( void ) const;
+
+    /**
+     * @brief bulkBuffer where the rest of the bulk string being parsed goes, so a large value
+     * can be received straight into it instead of through feed().
+     * @param pDest [out] the first byte not filled yet.
+     * @return the number of bytes still missing, 0 if no bulk string is being parsed.
+     */
+    size_t bulkBuffer( char*& pDest );
+
+    /**
+     * @brief bulkFilled tell the parser n bytes were written to the buffer of bulkBuffer().
+     * @return false: the handler stopped the reply.
+     */
+    bool bulkFilled( size_t n );
+
+    /**
+     * @brief depth
+     * @return number of arrays not complete yet.
+     */
+    size_t depth( void ) const;
+
+    /**
+     * @brief setMaxSize limit the bytes of one reply. The lengths announced in the reply are
+     * checked before its data is received.
+     * @param maxSize [in] 0: no limit.
+     */
+    void setMaxSize( uint64_t maxSize );
+    uint64_t getMaxSize( void ) const;
+
+    /**
+     * @brief attribute
+     * @return the last attribute met in the reply being parsed, a map. NIL if none.
+     */
+    const CResult& attribute( void ) const;
+
+    /**
+     * @brief parseLength parse the length of a bulk string or an array.
+     * @return the length, -1 for NIL.
+     * @warning throw ProtocolErr when it is not a valid length.
+     */
+    static int64_t parseLength( const char* data, size_t len );
+
+    static const char PREFIX_REPLY_STATUS = '+';
+    static const char PREFIX_REPLY_ERR = '-';
+    static const char PREFIX_REPLY_INT = ':';
+    static const char PREFIX_BULK_REPLY = '$';
+    static const char PREFIX_MULTI_BULK_REPLY = '*';
+    //------RESP3
+    static const char PREFIX_REPLY_DOUBLE = ',';
+    static const char PREFIX_REPLY_BOOL = '#';
+    static const char PREFIX_REPLY_BIGNUM = '(';
+    static const char PREFIX_REPLY_NULL = '_';
+    static const char PREFIX_VERBATIM_REPLY = '=';
+    static const char PREFIX_BLOB_ERR_REPLY = '!';
+    static const char PREFIX_MAP_REPLY = '%';
+    static const char PREFIX_SET_REPLY = '~';
+    static const char PREFIX_PUSH_REPLY = '>';
+    static const char PREFIX_ATTRIBUTE_REPLY = '|';
+
+private:
+    DISALLOW_COPY_AND_ASSIGN( CRedisParser );
+
+    enum
+    {
+        MAX_RESERVE_ELEMENTS = 1024 * 1024,		///< most elements reserved up front for one array.
+        MAX_SCRATCH_KEEP = 64 * 1024				///< _scratch larger than this is freed by reset().
+    };
+
+    enum State
+    {
+        STATE_LINE,			///< reading a "<type><content>\r\n" line.
+        STATE_BULK,			///< reading the data of a bulk string.
+        STATE_BULK_CRLF,	///< reading the "\r\n" after the data of a bulk string.
+        STATE_DONE,			///< the reply is complete.
+        STATE_ABORTED		///< the handler stopped the reply.
+    };
+
+    ///< an array not complete yet.
+    struct Frame
+    {
+        Frame( CResult* node, int64_t left, bool attribute = false ):
+            node( node ),
+            left( left ),
+            attribute( attribute )
+        {
+        }
+
+        CResult* node;		///< the array, NULL with a handler. Only ancestors are kept, so growing an array never moves a node on the stack.
+        int64_t left;		///< number of elements still to be parsed.
+        bool attribute;		///< an attribute, it is not a value, the value it describes comes after it.
+    };
+
+    void _begin( void );
+
+    /**
+     * @brief _handling
+     * @return true: values go to _pHandler. An attribute is always stored in _attribute.
+     */
+    bool _handling( void ) const;
+
+    /**
+     * @brief _beginBulk the data of a bulk string, a verbatim string or a blob error comes next.
+     */
+    void _beginBulk( char type, int64_t size );
+
+    /**
+     * @brief _beginAttribute an attribute of num pairs starts.
+     */
+    void _beginAttribute( int64_t num );
+
+    /**
+     * @brief _aggregateSize
+     * @return number of elements of an aggregate, a map has 2 for each pair. -1 for NIL.
+     */
+    static int64_t _aggregateSize( char type, int64_t num );
+
+    static ReplyType _replyType( char type );
+
+    static bool _parseBool( const char* data, size_t len );
+
+    /**
+     * @brief _parseLine handle a whole line without "\n".
+     */
+    void _parseLine( const char* line, size_t len );
+
+    /**
+     * @brief _handleLine hand a parsed line to _pHandler.
+     */
+    void _handleLine( char type, const char* data, size_t len );
+
+    /**
+     * @brief _nextNode
+     * @return where the next value is stored: the root, or a new element of the innermost array.
+     */
+    CResult* _nextNode( void );
+
+    /**
+     * @brief _bulkDone the data of the bulk string is complete, the "\r\n" comes next.
+     * @param data [in] the data of the bulk string.
+     */
+    void _bulkDone( const char* data );
+
+    /**
+     * @brief _valueDone a value is complete, close the arrays it completes.
+     */
+    void _valueDone( void );
+
+    /**
+     * @brief _handled stop the reply when the handler returned false.
+     * @return ok
+     */
+    bool _handled( bool ok );
+
+    /**
+     * @brief _addSize count bytes of the reply against _maxSize.
+     */
+    void _addSize( uint64_t bytes );
+
+    CResult* _pResult;				///< the reply being parsed, NULL with a handler.
+    CResult _attribute;			///< the last attribute met.
+    size_t _attrDepth;				///< number of attributes on _stack.
+    CRedisReplyHandler* _pHandler;	///< receives the reply being parsed, NULL without.
+    std::vector<Frame> _stack;		///< arrays being parsed, the innermost at the back.
+    State _state;
+    string _line;					///< part of a line split across feeds.
+    string* _pBulk;				///< bulk string being filled, NULL if none is being copied.
+    string _scratch;				///< bulk string split across feeds, with a handler.
+    char _bulkType;				///< prefix of the bulk string being parsed.
+    size_t _bulkSize;				///< length of the bulk string being parsed.
+    size_t _bulkFilled;			///< bytes of the bulk string already filled.
+    size_t _crlfLeft;				///< bytes of "\r\n" still to be skipped after a bulk string.
+    uint64_t _maxSize;				///< most bytes of one reply, 0: no limit.
+    uint64_t _size;				///< bytes of the current reply counted so far.
+};
+
+#endif // CREDISPARSER_H
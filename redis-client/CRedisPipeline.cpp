@@ -0,0 +1,82 @@
+/**
+ * @file	CRedisPipeline.cpp
+ * @brief 管道：一次写出多条指令，再按顺序读回全部回复，省去每条指令一次的 RTT。
+ */
+
+#include "CRedisPipeline.h"
+
+CRedisPipeline::CRedisPipeline( CRedisClient &redis ):
+    _redis( redis )
+{
+}
+
+CRedisPipeline::CRedisPipeline( const CRedisPool::Handle &handle ):
+    _handle( handle ),
+    _redis( *handle )
+{
+}
+
+CRedisPipeline::~CRedisPipeline()
+{
+}
+
+Command &CRedisPipeline::add( const string &cmd )
+{
+    _cmds.push_back( Command( cmd ) );
+    return _cmds.back();
+}
+
+Command &CRedisPipeline::add( const CmdHeader &header )
+{
+    _cmds.push_back( Command( header ) );
+    return _cmds.back();
+}
+
+size_t CRedisPipeline::add( const Command &cmd )
+{
+    _cmds.push_back( cmd );
+    return _cmds.size() - 1;
+}
+
+size_t CRedisPipeline::size( void ) const
+{
+    return _cmds.size();
+}
+
+void CRedisPipeline::clear( void )
+{
+    _cmds.clear();
+}
+
+size_t CRedisPipeline::exec( VecResult &results )
+{
+    results.clear();
+    if ( _cmds.empty() )
+    {
+        return 0;
+    }
+
+    QueCommand cmds;
+    cmds.swap( _cmds );
+
+    Command::VecIovec iov;
+    QueCommand::iterator it = cmds.begin();
+    for ( ; it != cmds.end(); ++it )
+    {
+        it->makeIovec( iov );
+    }
+    _redis._sendRequests( iov, static_cast<uint32_t>( cmds.size() ) );
+
+    size_t errNum = 0;
+    results.resize( cmds.size() );
+    VecResult::iterator rit = results.begin();
+    for ( ; rit != results.end(); ++rit )
+    {
+        _redis._getReply( *rit );
+        if ( REDIS_REPLY_ERROR == rit->getType() )
+        {
+            ++errNum;
+        }
+    }
+    return errNum;
+}
@@ -0,0 +1,87 @@
+/**
+ * @file	CRedisPipeline.h
+ * @brief 管道：一次写出多条指令，再按顺序读回全部回复，省去每条指令一次的 RTT。
+ *
+ * CRedisPipeline pipe( redis );
+ * pipe.add( CMD_HSET ) << key << field << value;
+ * pipe.add( "ZADD" ) << key << score << member;
+ * CRedisPipeline::VecResult results;
+ * pipe.exec( results );
+ */
+
+#ifndef CREDISPIPELINE_H
+#define CREDISPIPELINE_H
+
+#include <deque>
+#include <vector>
+#include "CRedisClient.h"
+#include "CRedisPool.h"
+
+class CRedisPipeline
+{
+public:
+    typedef std::vector<CResult> VecResult;
+
+    /**
+     * @brief CRedisPipeline queue commands for redis.
+     * @param redis [in] the connection used by exec(), it must outlive the pipeline.
+     */
+    explicit CRedisPipeline( CRedisClient& redis );
+
+    /**
+     * @brief CRedisPipeline queue commands for the connection of a pool handle.
+     * The handle is held, so the connection is not pushed back while the pipeline is alive.
+     */
+    explicit CRedisPipeline( const CRedisPool::Handle& handle );
+
+    ~CRedisPipeline();
+
+    /**
+     * @brief add queue a command built in place.
+     * @param cmd [in] name of the command, or a header from CmdHeader.h
+     * @return the queued command, add params to it with operator<<.
+     * @warning buffers referred by Command::Ref must stay alive until exec() returns.
+     */
+    Command& add( const string& cmd );
+    Command& add( const CmdHeader& header );
+
+    /**
+     * @brief add queue a copy of cmd.
+     * @return index of its reply in the results of exec().
+     */
+    size_t add( const Command& cmd );
+
+    /**
+     * @brief size
+     * @return number of commands queued.
+     */
+    size_t size( void ) const;
+
+    /**
+     * @brief clear drop the queued commands without sending them.
+     */
+    void clear( void );
+
+    /**
+     * @brief exec send all the queued commands with one write, then read their replies in order.
+     * The queue is empty afterwards.
+     * @param results [out] one reply per command, in the order they were added.
+     * An error reply is stored as REDIS_REPLY_ERROR instead of being thrown,
+     * so one failed command does not lose the replies of the others.
+     * @return the number of error replies.
+     * @warning throw ConnectErr when the connection fails, the connection is reconnected by
+     * the next request.
+     */
+    size_t exec( VecResult& results );
+
+private:
+    DISALLOW_COPY_AND_ASSIGN( CRedisPipeline );
+
+    typedef std::deque<Command> QueCommand;
+
+    CRedisPool::Handle _handle;		///< keeps a pooled connection, may be empty.
+    CRedisClient& _redis;			///< connection the commands are sent to.
+    QueCommand _cmds;				///< commands queued.
+};
+
+#endif // CREDISPIPELINE_H
@@ -24,6 +24,8 @@ CRedisPool::CRedisPool( )
 	_password.clear();
 	_timeout = 0;
 	_poolSize = DEFALUT_SIZE;
+	_recvBufferSize = CRedisSocket::RECEIVE_BUFFER_SIZE;
+	_maxRecvBufferSize = CRedisSocket::MAX_RECEIVE_BUFFER_SIZE;
 	_connList.clear();
 	srand(time(NULL));
 }
@@ -34,7 +36,8 @@ CRedisPool::~CRedisPool( )
 }
 
 bool CRedisPool::init( const std::string& host , uint16_t port , const std::string& password ,
-		uint32_t timeout , int32_t poolSize , uint32_t nScanTime )
+		uint32_t timeout , int32_t poolSize , uint32_t nScanTime ,
+		uint32_t recvBufferSize , uint32_t maxRecvBufferSize )
 {
 	_scanTime = nScanTime;
 	_host = host;
@@ -42,6 +45,8 @@ bool CRedisPool::init( const std::string& host , uint16_t port , const std::stri
 	_password = password;
 	_timeout = timeout;
 	_poolSize = poolSize;
+	_recvBufferSize = recvBufferSize;
+	_maxRecvBufferSize = maxRecvBufferSize;
 	_connList.resize(_poolSize, NULL);
 
 	int32_t i;
@@ -50,6 +55,7 @@ bool CRedisPool::init( const std::string& host , uint16_t port , const std::stri
 		SRedisConn* pRedisConn = new SRedisConn;
 		pRedisConn->idle = true;
 		pRedisConn->connStatus = true;
+		pRedisConn->conn.setRecvBuffer(_recvBufferSize, _maxRecvBufferSize);
         pRedisConn->conn.connect(_host, _port);
 		_connList[i] = pRedisConn;
 	}
@@ -108,7 +114,10 @@ void CRedisPool::pushBackConn( CRedisClient *&pConn )
 		if ( _connList[i] != NULL )
 		{
 			if ( &( _connList[i]->conn ) == pConn )
+			{
+				_connList[i]->conn.shrinkRecvBuffer();
 				_connList[i]->idle = true;
+			}
 		}
 	}
 	_cond.signal();
@@ -119,6 +128,7 @@ void CRedisPool::pushBackConn( int32_t connNum )
 	if ( _status != REDIS_POOL_WORKING )
 		return;
 	Poco::Mutex::ScopedLock lock(_mutex);
+	_connList[connNum]->conn.shrinkRecvBuffer();
 	_connList[connNum]->idle = true;
     _cond.signal();
 }
@@ -142,12 +152,26 @@ CRedisPool::Handle CRedisPool::getRedis(long millisecond)
      return CRedisPool::Handle( predis,deleter );
 }
 
+void CRedisPool::enableCache( CRedisCache *pCache )
+{
+	Poco::Mutex::ScopedLock lock(_mutex);
+	int32_t i;
+	for ( i = 0; i < _poolSize ; i++ )
+	{
+		if ( _connList[i] != NULL )
+		{
+			_connList[i]->conn.enableCache( pCache );
+		}
+	}
+}
+
 void CRedisPool::closeConnPool( void )
 {
     if ( _status != REDIS_POOL_WORKING )
 		return;
 	_mutex.lock();
 	_status = REDIS_POOL_DEAD;
+	_scanCond.broadcast();
 	int32_t i;
 	SRedisConn* pRedisConn;
 	for ( i = 0; i < _poolSize ; i++ )
@@ -200,11 +224,11 @@ void CRedisPool::_keepAlive( void )
 			try
 			{
 				pRedisConn->conn.reconnect();
-			} catch( Poco::Exception& e )
+			} catch( std::exception& e )
 			{
 				pRedisConn->idle = true;
 				pRedisConn->connStatus = false;
-                REDIS_DEBUGOUT("CRedisPool::keepAlive:------reconnect--Error:---", e.message());
+                REDIS_DEBUGOUT("CRedisPool::keepAlive:------reconnect--Error:---", e.what());
                 REDIS_DEBUGOUT("the connect number ", i);
 			}
 		}
@@ -218,7 +242,13 @@ void CRedisPool::__onRunCallBack( void* pVoid )
 	{
 		while ( pRedisPool->_status == CRedisPool::REDIS_POOL_WORKING )
 		{
-			::sleep(pRedisPool->_scanTime);
+			{
+				Poco::Mutex::ScopedLock lock( pRedisPool->_mutex );
+				if ( pRedisPool->_status != CRedisPool::REDIS_POOL_WORKING )
+					break;
+				// woken up at once by closeConnPool(), not after the whole scan time.
+				pRedisPool->_scanCond.tryWait( pRedisPool->_mutex, static_cast<long>( pRedisPool->_scanTime ) * 1000 );
+			}
 			pRedisPool->_keepAlive();
 		}
 	}
@@ -4,6 +4,8 @@
  * @file	CRedisPool.h		
  * @brief CRedisPool class is to create and manage redis connections in the buffer pool.
  * These connections are ready to be used by any thread that needs them.
+ * They are blocking CRedisClient, one per thread at a time. To share a few connections among many
+ * threads or servers on one I/O thread, use CRedisMultiplexer and CRedisEventLoop instead.
  * @author: 		yp
  * @date: 		Jul 6, 2015
  *
@@ -14,6 +16,7 @@
 
 
 #include "CRedisClient.h"
+#include "CRedisCache.h"
 #include <Poco/Condition.h>
 #include <memory>
 
@@ -30,7 +33,7 @@ public:
 
 	/**
 	* @brief initial connection pool, starting scan thread
-	* @param host [in] host ip
+	* @param host [in] host ip, or the path of a unix socket, eg: /var/run/redis/redis.sock.
 	* @param port [in] host port
 	* @param password [in] host password
 	* @param timeout [in] timeout period, default 0
@@ -38,11 +41,16 @@ public:
 	* @param maxSize [in] maximum value of connections, default 10
 	* @param nScanTime [in] thread scan time, default 60
 	* @param idleTime [in] idle time, default 60
+	* @param recvBufferSize [in] initial receive buffer size of each connection
+	* @param maxRecvBufferSize [in] size the receive buffer of each connection may grow to.
+	* It is shrunk back to recvBufferSize when the connection is pushed back.
 	* @return if success return true else return false
 	* @warning return value must be checked.pool can't be used when false is returned.
 	*/
     bool init(const std::string& host, uint16_t port, const std::string& password, uint32_t timeout=0,
-             int32_t  poolSize=DEFALUT_SIZE, uint32_t nScanTime = 60);
+             int32_t  poolSize=DEFALUT_SIZE, uint32_t nScanTime = 60,
+             uint32_t recvBufferSize = CRedisSocket::RECEIVE_BUFFER_SIZE,
+             uint32_t maxRecvBufferSize = CRedisSocket::MAX_RECEIVE_BUFFER_SIZE );
 
 	/**
 	* @brief get a single connection in the pool
@@ -62,6 +70,14 @@ public:
 
     Handle getRedis(long millisecond );
 
+	/**
+	* @brief enableCache serve get(), hget() and hmget() of all the connections from pCache.
+	* @param pCache [in] it must be listening, see CRedisCache::listen(), and outlive the pool.
+	* @warning call it after init() and before connections are taken. throw like
+	* CRedisClient::enableCache() does.
+	*/
+    void enableCache( CRedisCache* pCache );
+
 	/**
 	* @brief close connection pool
 	* @warning Free idle connection, waiting for the scan thread to end.
@@ -102,6 +118,8 @@ private:
 	std::string _password;		///< host password
 	uint32_t _timeout;		///< timeout period, default 0
     int32_t _poolSize;		///< minimum value of connections, default 5
+	uint32_t _recvBufferSize;	///< initial receive buffer size of each connection
+	uint32_t _maxRecvBufferSize;	///< max receive buffer size of each connection
 
 	RedisConnList _connList;	///< the list of redis connection pool
 
@@ -112,6 +130,7 @@ private:
 
 	Poco::Mutex _mutex;
 	Poco::Condition _cond;
+	Poco::Condition _scanCond;	///< closeConnPool() wakes the scan thread up with it
 	DISALLOW_COPY_AND_ASSIGN(CRedisPool);
 
 	/**
@@ -1,9 +1,19 @@
 #include "CRedisSocket.h"
 #include "RdException.hpp"
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <algorithm>
 
 
 
 CRedisSocket::CRedisSocket():
+    _pTransport( CRedisTransport::create( CRedisTransport::TRANSPORT_POSIX ) ),
+    _bufferSize( RECEIVE_BUFFER_SIZE ),
+    _initBufferSize( RECEIVE_BUFFER_SIZE ),
+    _maxBufferSize( MAX_RECEIVE_BUFFER_SIZE ),
+    _bufferFull( false ),
     _pBuffer(0),
     _pNext(0),
     _pEnd(0)
@@ -11,22 +21,85 @@ CRedisSocket::CRedisSocket():
     _allocBuffer();
 }
 
-CRedisSocket::CRedisSocket(const Poco::Net::SocketAddress &address ):
-    StreamSocket(address),
+CRedisSocket::CRedisSocket(const SocketAddress &address ):
+    _pTransport( CRedisTransport::create( CRedisTransport::TRANSPORT_POSIX ) ),
+    _bufferSize( RECEIVE_BUFFER_SIZE ),
+    _initBufferSize( RECEIVE_BUFFER_SIZE ),
+    _maxBufferSize( MAX_RECEIVE_BUFFER_SIZE ),
+    _bufferFull( false ),
     _pBuffer(0),
     _pNext(0),
     _pEnd(0)
 {
     _allocBuffer();
+    connect( address );
 }
 
 
 
 CRedisSocket::~CRedisSocket()
 {
+    delete _pTransport;
     delete [] _pBuffer;
 }
 
+void CRedisSocket::setTransport( CRedisTransport::Type type )
+{
+    if ( type == _pTransport->type() )
+    {
+        return;
+    }
+    delete _pTransport;
+    // the provided buffers of io_uring are as large as the receive buffer at rest.
+    _pTransport = CRedisTransport::create( type, _initBufferSize );
+    resetBuffer();
+}
+
+CRedisTransport::Type CRedisSocket::getTransport( void ) const
+{
+    return _pTransport->type();
+}
+
+void CRedisSocket::connect( const SocketAddress &address, const Timespan &timeout )
+{
+    _pTransport->connect( address, timeout );
+}
+
+void CRedisSocket::connectUnix( const string &path, const Timespan &timeout )
+{
+    _pTransport->connectUnix( path, timeout );
+}
+
+void CRedisSocket::close( void )
+{
+    _pTransport->close();
+}
+
+void CRedisSocket::shutdown( void )
+{
+    _pTransport->shutdown();
+}
+
+void CRedisSocket::setSendTimeout( const Timespan &timeout )
+{
+    _pTransport->setSendTimeout( timeout );
+}
+
+void CRedisSocket::setReceiveTimeout( const Timespan &timeout )
+{
+    _pTransport->setReceiveTimeout( timeout );
+}
+
+size_t CRedisSocket::send( const char *data, size_t len )
+{
+    return _pTransport->send( data, len );
+}
+
+int CRedisSocket::available( void )
+{
+    return _pTransport->available();
+}
+
 int CRedisSocket::get()
 {
     _refill();
@@ -48,71 +121,185 @@ int CRedisSocket::peek()
 bool CRedisSocket::readLine( string& line )
 {
     line.clear();
-    int ch = get();
-    //----修复读取一行的内容中只包含'\r'或'\n'的情况----by FanYongTao ,needs review
-    while(1)
+    while ( 1 )
     {
-        if( ch == EOF_CHAR )
+        _refill();
+        // memchr is vectorized by libc, scan the whole buffered window at once.
+        const char* pCR = static_cast<const char*>( memchr( _pNext, '\r', _pEnd - _pNext ) );
+        if ( NULL == pCR )
+        {
+            line.append( _pNext, _pEnd - _pNext );
+            _pNext = _pEnd;
+            continue;
+        }
+
+        line.append( _pNext, pCR - _pNext );
+        _pNext = const_cast<char*>( pCR ) + 1;
+
+        // peek() refills when '\r' was the last buffered byte, so a CRLF split across two reads is handled here.
+        int ch = peek();
+        if ( ch == EOF_CHAR )
         {
             return false;
-        }else if( ch == '\r' && peek() == '\n')
+        }else if ( ch == '\n' )
         {
-            get();
+            ++_pNext;
             return true;
-        }else
-        {
-            line += ch;
-            ch = get();
         }
+        //----a single '\r' belongs to the line content.
+        line += '\r';
     }
 }
 
 void CRedisSocket::readN(const uint64_t n, string& data )
 {
+    data.resize( n );
+    if ( 0 == n )
+    {
+        return;
+    }
+
+    char* pDest = &data[0];
     uint64_t readed = 0;
-    char ch = 0;
-    data.clear();
 
-    for ( readed=0; readed != n; ++readed )
+    //------copy whatever is already in the application buffer.
+    uint64_t len = std::min<uint64_t>( _pEnd - _pNext, n );
+    memcpy( pDest, _pNext, len );
+    _pNext += len;
+    readed += len;
+
+    //------large payload: receive straight into data, no bounce through _pBuffer.
+    while ( n - readed >= _bufferSize )
     {
-        ch = get();
-        if ( ch == EOF_CHAR )
+        size_t got = _pTransport->receive( pDest + readed, n - readed );
+        if ( 0 == got )
         {
-            break;
+            throw ConnectErr( "socket is disconnect!" );
         }
-        data += ch;
+        readed += got;
+    }
+
+    //------small tail: refill the buffer so that the following CRLF comes with it.
+    while ( readed != n )
+    {
+        _refill();
+        len = std::min<uint64_t>( _pEnd - _pNext, n - readed );
+        memcpy( pDest + readed, _pNext, len );
+        _pNext += len;
+        readed += len;
     }
 }
 
+const char *CRedisSocket::bufferedData( void ) const
+{
+    return _pNext;
+}
+
+size_t CRedisSocket::bufferedSize( void ) const
+{
+    return _pEnd - _pNext;
+}
+
+void CRedisSocket::consume( size_t n )
+{
+    _pNext += std::min<size_t>( n, _pEnd - _pNext );
+}
+
+void CRedisSocket::fillBuffer( void )
+{
+    _refill();
+}
+
+size_t CRedisSocket::receiveDirect( char *pDest, size_t len )
+{
+    size_t got = _pTransport->receive( pDest, len );
+    if ( 0 == got )
+    {
+        throw ConnectErr( "socket is disconnect!" );
+    }
+    return got;
+}
+
+size_t CRedisSocket::sendv( const struct iovec* iov, int count )
+{
+    return _pTransport->sendv( iov, count );
+}
+
 void CRedisSocket::clearBuffer( void )
+{
+   resetBuffer();
+   _flushSocketRecvBuff();
+}
+
+void CRedisSocket::resetBuffer( void )
 {
    _pNext = _pBuffer;
    _pEnd = _pBuffer;
-   _flushSocketRecvBuff();
+}
+
+void CRedisSocket::setBufferPolicy( uint32_t initSize, uint32_t maxSize )
+{
+    if ( 0 == initSize )
+    {
+        initSize = RECEIVE_BUFFER_SIZE;
+    }
+    _initBufferSize = initSize;
+    _maxBufferSize = std::max( initSize, maxSize );
+
+    if ( _pNext == _pEnd && _bufferSize != _initBufferSize )
+    {
+        _resizeBuffer( _initBufferSize );
+    }
+}
+
+void CRedisSocket::shrinkBuffer( void )
+{
+    _bufferFull = false;
+    if ( _pNext == _pEnd && _bufferSize > _initBufferSize )
+    {
+        _resizeBuffer( _initBufferSize );
+    }
+}
+
+uint32_t CRedisSocket::getBufferSize( void ) const
+{
+    return _bufferSize;
 }
 
 //----------------------------------------------protected----------------------------------------------------
 void CRedisSocket::_allocBuffer()
 {
-    _pBuffer = new char [RECEIVE_BUFFER_SIZE];
+    _pBuffer = new char [_bufferSize];
     _pNext   = _pBuffer;
     _pEnd    = _pBuffer;
 }
 
+void CRedisSocket::_resizeBuffer( uint32_t size )
+{
+    delete [] _pBuffer;
+    _pBuffer = 0;
+    _bufferSize = size;
+    _allocBuffer();
+}
+
 void CRedisSocket::_refill()
 {
     if (_pNext == _pEnd)
     {
-        int n = receiveBytes(_pBuffer, RECEIVE_BUFFER_SIZE);
-        if ( n <=0 )
+        // the last receive filled the buffer up, a large reply is coming in.
+        if ( _bufferFull && _bufferSize < _maxBufferSize )
         {
-            throw ConnectErr( "socket is disconnect!" );
+            _resizeBuffer( static_cast<uint32_t>( std::min<uint64_t>( _bufferSize * 2ULL, _maxBufferSize ) ) );
         }
-        if (n > 0)
+
+        size_t n = _pTransport->receive( _pBuffer, _bufferSize );
+        if ( 0 == n )
         {
-            _pNext = _pBuffer;
-            _pEnd  = _pBuffer + n;
+            throw ConnectErr( "socket is disconnect!" );
         }
+        _bufferFull = ( n == _bufferSize );
+        _pNext = _pBuffer;
+        _pEnd  = _pBuffer + n;
     }
 }
 
@@ -122,7 +309,11 @@ void CRedisSocket::_flushSocketRecvBuff()
     timeout.tv_sec = 0;
     timeout.tv_usec = 0;
 
-    int fd = impl()->sockfd();
+    int fd = _pTransport->fd();
+    if ( fd < 0 )
+    {
+        return;
+    }
 
     fd_set         fds;
     FD_ZERO(&fds);
@@ -2,27 +2,80 @@
 #define CREDISSOCKET_H
 
 #include "redisCommon.h"
-#include <Poco/Net/StreamSocket.h>
+#include <sys/uio.h>
+#include "CRedisTransport.h"
 
-using Poco::Net::StreamSocket;
-using Poco::Net::SocketAddress;
-using Poco::Net::Socket;
-
-class CRedisSocket : public StreamSocket
+/**
+ * @brief The CRedisSocket class buffers what a CRedisTransport receives, the transport
+ * is a CRedisPosixTransport unless setTransport() says otherwise.
+ */
+class CRedisSocket
 {
 public:
+    enum
+    {
+        RECEIVE_BUFFER_SIZE     = 1024,         ///< default initial size of the receive buffer.
+        MAX_RECEIVE_BUFFER_SIZE = 64 * 1024     ///< default size the receive buffer may grow to.
+    };
+
     CRedisSocket();
     explicit CRedisSocket(const SocketAddress& address );
 
     ~CRedisSocket();
 
+    /**
+     * @brief setTransport replace the transport, the current connection is closed.
+     * The receive buffers of the transport, if it has any, are sized like the initial size of
+     * this one, see setBufferPolicy().
+     */
+    void setTransport( CRedisTransport::Type type );
+    CRedisTransport::Type getTransport( void ) const;
+
+    /**
+     * @brief connect close the current connection if any, then connect to address.
+     * @param timeout [in] 0: wait as long as it takes.
+     * @warning throw ConnectErr when it can not connect in time.
+     */
+    void connect( const SocketAddress& address, const Timespan& timeout = Timespan() );
+
+    /**
+     * @brief connectUnix like connect(), to the unix domain socket at path.
+     */
+    void connectUnix( const string& path, const Timespan& timeout = Timespan() );
+    void close( void );
+
+    /**
+     * @brief shutdown stop both directions, a thread blocked receiving returns, eg: from another thread.
+     */
+    void shutdown( void );
+
+    /**
+     * @brief setSendTimeout
+     * @param timeout [in] 0: no timeout.
+     */
+    void setSendTimeout( const Timespan& timeout );
+    void setReceiveTimeout( const Timespan& timeout );
+
+    /**
+     * @brief send
+     * @return bytes sent, it may be less than len.
+     * @warning throw ConnectErr when the socket fails or times out.
+     */
+    size_t send( const char* data, size_t len );
+
+    /**
+     * @brief available
+     * @return bytes received by the system but not by the buffer yet.
+     */
+    int available( void );
+
 
     int get( void );
 
     int peek( void );
 
     /**
- * @brief readLine 从 socket 读取一行
+ * @brief readLine 从 socket 读取一行,在缓冲区内用 memchr 查找 "\r\n" 并整段追加。
  * @param line
  * @return
  *
@@ -34,17 +87,77 @@ public:
     * @brief readN
     * @param n [in] 		The length of the data you want to receive.
     * @param data [out]		date recved
+    * @warning data is resized to n up front. Bytes already buffered are copied in one go,
+    * a large remainder is received directly into data.
     */
     void readN( const uint64_t n, string &data );
 
+    /**
+     * @brief bufferedData
+     * @return the first byte received but not consumed yet, there are bufferedSize() of them.
+     */
+    const char* bufferedData( void ) const;
+    size_t bufferedSize( void ) const;
+
+    /**
+     * @brief consume mark n bytes of bufferedData() as used.
+     */
+    void consume( size_t n );
+
+    /**
+     * @brief fillBuffer receive into the buffer when nothing is left in it, blocks until
+     * some bytes come in.
+     * @warning throw ConnectErr when the socket is disconnected or times out.
+     */
+    void fillBuffer( void );
+
+    /**
+     * @brief receiveDirect receive into pDest without going through the buffer,
+     * only valid when the buffer is empty.
+     * @return bytes received, no more than len.
+     * @warning throw ConnectErr when the socket is disconnected or times out.
+     */
+    size_t receiveDirect( char* pDest, size_t len );
+
+    /**
+     * @brief sendv send several buffers with one sendmsg() call.
+     * @param iov [in] buffers to send.
+     * @param count [in] number of buffers, no more than IOV_MAX.
+     * @return bytes sent, it may be less than the total length of the buffers.
+     * @warning throw ConnectErr when the socket fails or times out.
+     */
+    size_t sendv( const struct iovec* iov, int count );
+
     /**
      * @brief clearBuffer 清空原始 socket 和应用缓冲区
      */
     void clearBuffer( void );
 
+    /**
+     * @brief resetBuffer drop the data in the application buffer only, eg: before reconnecting.
+     */
+    void resetBuffer( void );
+
+    /**
+     * @brief setBufferPolicy set the size policy of the receive buffer.
+     * @param initSize [in] size the buffer starts with and shrinks back to.
+     * @param maxSize [in] size the buffer may grow to. The buffer is doubled each time
+     * a receive fills it up, which means a large reply is being transferred.
+     */
+    void setBufferPolicy( uint32_t initSize, uint32_t maxSize );
+
+    /**
+     * @brief shrinkBuffer give back the memory of a grown buffer.
+     * Nothing is done when there is still unread data in the buffer.
+     */
+    void shrinkBuffer( void );
+
+    uint32_t getBufferSize( void ) const;
+
 protected:
 
     void _allocBuffer( void );
+    void _resizeBuffer( uint32_t size );
     void _refill( void );
     /**
      * @brief _flushRecvBuff  Clear receiving buffer of raw socket.
@@ -56,11 +169,15 @@ private:
 
     enum
     {
-        RECEIVE_BUFFER_SIZE = 1024,
         EOF_CHAR            = -1
     };
 
 
+    CRedisTransport* _pTransport;	///< sends and receives the bytes.
+    uint32_t _bufferSize;		///< current size of _pBuffer.
+    uint32_t _initBufferSize;	///< size _pBuffer starts with and shrinks back to.
+    uint32_t _maxBufferSize;	///< size _pBuffer may grow to.
+    bool _bufferFull;		///< the last receive filled _pBuffer up.
     char* _pBuffer;		///< a buffer that  stores received data.
     char* _pNext;		///< a pointer that points to the data to be  read.
     char* _pEnd;		///< the end of the buffer.
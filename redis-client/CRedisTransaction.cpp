@@ -0,0 +1,165 @@
+/**
+ * @file	CRedisTransaction.cpp
+ * @brief 事务：在本地缓存指令，WATCH、MULTI、指令和 EXEC 一次写出，再一次读回全部回复。
+ */
+
+#include "CRedisTransaction.h"
+#include "RdException.hpp"
+
+CRedisTransaction::CRedisTransaction( CRedisClient &redis ):
+    _redis( redis )
+{
+}
+
+CRedisTransaction::CRedisTransaction( const CRedisPool::Handle &handle ):
+    _handle( handle ),
+    _redis( *handle )
+{
+}
+
+CRedisTransaction::~CRedisTransaction()
+{
+}
+
+void CRedisTransaction::watch( const CRedisClient::VecString &keys )
+{
+    _watchKeys.insert( _watchKeys.end(), keys.begin(), keys.end() );
+}
+
+void CRedisTransaction::watch( const string &key )
+{
+    _watchKeys.push_back( key );
+}
+
+Command &CRedisTransaction::add( const string &cmd )
+{
+    _cmds.push_back( Command( cmd ) );
+    return _cmds.back();
+}
+
+Command &CRedisTransaction::add( const CmdHeader &header )
+{
+    _cmds.push_back( Command( header ) );
+    return _cmds.back();
+}
+
+size_t CRedisTransaction::add( const Command &cmd )
+{
+    _cmds.push_back( cmd );
+    return _cmds.size() - 1;
+}
+
+size_t CRedisTransaction::size( void ) const
+{
+    return _cmds.size();
+}
+
+void CRedisTransaction::clear( void )
+{
+    _watchKeys.clear();
+    _cmds.clear();
+}
+
+bool CRedisTransaction::exec( CResult &result )
+{
+    QueCommand cmds;
+    cmds.swap( _cmds );
+    CRedisClient::VecString watchKeys;
+    watchKeys.swap( _watchKeys );
+
+    Command watch( "WATCH" );
+    Command multi( "MULTI" );
+    Command exec( "EXEC" );
+    Command::VecIovec iov;
+    uint32_t num = cmds.size() + 2;
+
+    if ( !watchKeys.empty() )
+    {
+        CRedisClient::VecString::const_iterator kit = watchKeys.begin();
+        for ( ; kit != watchKeys.end(); ++kit )
+        {
+            watch << *kit;
+        }
+        watch.makeIovec( iov );
+        ++num;
+    }
+    multi.makeIovec( iov );
+    QueCommand::iterator it = cmds.begin();
+    for ( ; it != cmds.end(); ++it )
+    {
+        it->makeIovec( iov );
+    }
+    exec.makeIovec( iov );
+    _redis._sendRequests( iov, num );
+
+    // read every reply before throwing, so nothing is left unread on the connection.
+    string err;
+    if ( !watchKeys.empty() )
+    {
+        _checkStatus( "WATCH", "OK", err );
+    }
+    _checkStatus( "MULTI", "OK", err );
+
+    string queueErr;
+    CResult reply;
+    for ( it = cmds.begin(); it != cmds.end(); ++it )
+    {
+        _redis._getReply( reply );
+        if ( REDIS_REPLY_ERROR == reply.getType() )
+        {
+            if ( queueErr.empty() )
+            {
+                queueErr = it->getCommand() + ": " + reply.getErrorString();
+            }
+        }else if ( REDIS_REPLY_STATUS != reply.getType() || "QUEUED" != reply.getStatus() )
+        {
+            if ( err.empty() )
+            {
+                err = "TRANSACTION recv unexpected data: " + it->getCommand();
+            }
+        }
+    }
+
+    _redis._getReply( result );
+
+    if ( !err.empty() )
+    {
+        throw ProtocolErr( err );
+    }
+    if ( !queueErr.empty() )
+    {
+        throw ReplyErr( queueErr );
+    }
+
+    ReplyType type = result.getType();
+    if ( REDIS_REPLY_NIL == type )
+    {
+        return false;
+    }
+    if ( REDIS_REPLY_ERROR == type )
+    {
+        throw ReplyErr( result.getErrorString() );
+    }
+    if ( REDIS_REPLY_ARRAY != type )
+    {
+        throw ProtocolErr( "EXEC: data recved is not arry" );
+    }
+    return true;
+}
+
+void CRedisTransaction::_checkStatus( const char *what, const char *expected, string &err )
+{
+    CResult reply;
+    _redis._getReply( reply );
+    if ( !err.empty() )
+    {
+        return;
+    }
+    if ( REDIS_REPLY_ERROR == reply.getType() )
+    {
+        err = string( what ) + ": " + reply.getErrorString();
+    }else if ( REDIS_REPLY_STATUS != reply.getType() || expected != reply.getStatus() )
+    {
+        err = string( what ) + " recv unexpected data";
+    }
+}
@@ -0,0 +1,98 @@
+/**
+ * @file	CRedisTransaction.h
+ * @brief 事务：在本地缓存指令，WATCH、MULTI、指令和 EXEC 一次写出，再一次读回全部回复。
+ *
+ * CRedisTransaction trans( redis );
+ * trans.watch( keys );
+ * trans.add( CMD_INCR ) << key;
+ * trans.add( "ZADD" ) << key << score << member;
+ * CResult result;
+ * if ( !trans.exec( result ) ) { // watched keys changed, nothing executed }
+ */
+
+#ifndef CREDISTRANSACTION_H
+#define CREDISTRANSACTION_H
+
+#include <deque>
+#include "CRedisClient.h"
+#include "CRedisPool.h"
+
+class CRedisTransaction
+{
+public:
+    /**
+     * @brief CRedisTransaction queue a transaction for redis.
+     * @param redis [in] the connection used by exec(), it must outlive the transaction.
+     */
+    explicit CRedisTransaction( CRedisClient& redis );
+
+    /**
+     * @brief CRedisTransaction queue a transaction for the connection of a pool handle.
+     * The handle is held, so the connection is not pushed back while the transaction is alive.
+     */
+    explicit CRedisTransaction( const CRedisPool::Handle& handle );
+
+    ~CRedisTransaction();
+
+    /**
+     * @brief watch keys are sent with WATCH in front of MULTI, in the same write.
+     * exec() fails if any of them is changed by others before EXEC.
+     */
+    void watch( const CRedisClient::VecString& keys );
+    void watch( const string& key );
+
+    /**
+     * @brief add queue a command of the transaction.
+     * @param cmd [in] name of the command, or a header from CmdHeader.h
+     * @return the queued command, add params to it with operator<<.
+     * @warning buffers referred by Command::Ref must stay alive until exec() returns.
+     */
+    Command& add( const string& cmd );
+    Command& add( const CmdHeader& header );
+
+    /**
+     * @brief add queue a copy of cmd.
+     * @return index of its reply in the result of exec().
+     */
+    size_t add( const Command& cmd );
+
+    /**
+     * @brief size
+     * @return number of commands queued, WATCH not counted.
+     */
+    size_t size( void ) const;
+
+    /**
+     * @brief clear drop the queued commands and watched keys without sending them.
+     */
+    void clear( void );
+
+    /**
+     * @brief exec send [WATCH] MULTI commands EXEC with one write, then check all the
+     * acknowledges and read the result of EXEC. The transaction is empty afterwards.
+     * @param result [out] array of replies, one per command, in the order they were added.
+     * @return true: transaction executed. false: a watched key was changed, nothing executed.
+     * @warning throw ReplyErr when a command is rejected while queuing, the transaction is
+     * discarded by redis. throw ProtocolErr when WATCH or MULTI is not acknowledged.
+     * All replies are read before throwing, the connection is still usable.
+     */
+    bool exec( CResult& result );
+
+private:
+    DISALLOW_COPY_AND_ASSIGN( CRedisTransaction );
+
+    typedef std::deque<Command> QueCommand;
+
+    /**
+     * @brief _checkStatus read one reply and check it is the status expected.
+     * @param err [in,out] description of the first failure, left unchanged if ok.
+     */
+    void _checkStatus( const char* what, const char* expected, string& err );
+
+    CRedisPool::Handle _handle;		///< keeps a pooled connection, may be empty.
+    CRedisClient& _redis;			///< connection the transaction is sent to.
+    CRedisClient::VecString _watchKeys;	///< keys sent with WATCH
+    QueCommand _cmds;				///< commands of the transaction.
+};
+
+#endif // CREDISTRANSACTION_H
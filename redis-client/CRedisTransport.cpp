@@ -0,0 +1,401 @@
+/**
+ * @file	CRedisTransport.cpp
+ * @brief CRedisSocket 下层的传输接口：POSIX 与 Poco 两种实现。
+ */
+
+#include "CRedisTransport.h"
+#include "CRedisUringTransport.h"
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <algorithm>
+
+CRedisTransport* CRedisTransport::create( Type type, uint32_t bufferSize )
+{
+    if ( TRANSPORT_POCO == type )
+    {
+        return new CRedisPocoTransport;
+    }
+#ifdef CREDIS_HAVE_IO_URING
+    if ( TRANSPORT_IO_URING == type && CRedisUringTransport::supported() )
+    {
+        try
+        {
+            return new CRedisUringTransport( bufferSize );
+        }catch( ConnectErr& )
+        {
+            // eg: out of locked memory for the ring, plain sockets do the same job.
+        }
+    }
+#endif
+    return new CRedisPosixTransport;
+}
+
+void CRedisTransport::unixAddress( const string &path, sockaddr_un &addr )
+{
+    memset( &addr, 0, sizeof( addr ) );
+    if ( path.empty() || path.size() >= sizeof( addr.sun_path ) )
+    {
+        throw ConnectErr( "invalid unix socket path: " + path );
+    }
+    addr.sun_family = AF_UNIX;
+    memcpy( addr.sun_path, path.data(), path.size() );
+}
+
+int CRedisTransport::startConnect( const sockaddr *pAddr, socklen_t len, bool &connected )
+{
+    int fd = ::socket( pAddr->sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+    if ( fd < 0 )
+    {
+        throw ConnectErr( string( "socket exception: " ) + strerror( errno ) );
+    }
+    if ( AF_INET == pAddr->sa_family || AF_INET6 == pAddr->sa_family )
+    {
+        // a request is written in one sendmsg(), do not let it wait for the ack of the last one.
+        int on = 1;
+        ::setsockopt( fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof( on ) );
+    }
+
+    connected = ( 0 == ::connect( fd, pAddr, len ) );
+    // interrupted, the connection is still being established in the background.
+    // a unix socket connects at once or fails, EAGAIN there means its backlog is full.
+    if ( !connected && EINPROGRESS != errno && EINTR != errno )
+    {
+        int err = errno;
+        ::close( fd );
+        throw ConnectErr( string( "connect exception: " ) + strerror( err ) );
+    }
+    return fd;
+}
+
+//----------------------------------------------posix----------------------------------------------------
+CRedisPosixTransport::CRedisPosixTransport():
+    _fd( -1 ),
+    _sendTimeoutMs( -1 ),
+    _recvTimeoutMs( -1 )
+{
+}
+
+CRedisPosixTransport::~CRedisPosixTransport()
+{
+    close();
+}
+
+CRedisTransport::Type CRedisPosixTransport::type( void ) const
+{
+    return TRANSPORT_POSIX;
+}
+
+void CRedisPosixTransport::connect( const SocketAddress &address, const Timespan &timeout )
+{
+    _connect( address.addr(), address.length(), timeout );
+}
+
+void CRedisPosixTransport::connectUnix( const string &path, const Timespan &timeout )
+{
+    struct sockaddr_un addr;
+    unixAddress( path, addr );
+    _connect( reinterpret_cast<const struct sockaddr*>( &addr ), sizeof( addr ), timeout );
+}
+
+void CRedisPosixTransport::_connect( const struct sockaddr *pAddr, socklen_t len, const Timespan &timeout )
+{
+    close();
+    bool connected = false;
+    _fd = startConnect( pAddr, len, connected );
+    if ( connected )
+    {
+        return;
+    }
+
+    try
+    {
+        _wait( POLLOUT, _toMs( timeout ), "connect" );
+
+        int err = 0;
+        socklen_t errLen = sizeof( err );
+        if ( ::getsockopt( _fd, SOL_SOCKET, SO_ERROR, &err, &errLen ) < 0 )
+        {
+            throw _error( "connect" );
+        }
+        if ( 0 != err )
+        {
+            errno = err;
+            throw _error( "connect" );
+        }
+    }catch( ... )
+    {
+        close();
+        throw;
+    }
+}
+
+void CRedisPosixTransport::close( void )
+{
+    if ( _fd >= 0 )
+    {
+        ::close( _fd );
+        _fd = -1;
+    }
+}
+
+void CRedisPosixTransport::shutdown( void )
+{
+    if ( _fd >= 0 )
+    {
+        ::shutdown( _fd, SHUT_RDWR );
+    }
+}
+
+void CRedisPosixTransport::setSendTimeout( const Timespan &timeout )
+{
+    _sendTimeoutMs = _toMs( timeout );
+}
+
+void CRedisPosixTransport::setReceiveTimeout( const Timespan &timeout )
+{
+    _recvTimeoutMs = _toMs( timeout );
+}
+
+size_t CRedisPosixTransport::send( const char *data, size_t len )
+{
+    while ( 1 )
+    {
+        ssize_t n = ::send( _fd, data, len, MSG_NOSIGNAL );
+        if ( n >= 0 )
+        {
+            return static_cast<size_t>( n );
+        }
+        if ( EINTR == errno )
+        {
+            continue;
+        }
+        if ( EAGAIN != errno && EWOULDBLOCK != errno )
+        {
+            throw _error( "send" );
+        }
+        _wait( POLLOUT, _sendTimeoutMs, "send" );
+    }
+}
+
+size_t CRedisPosixTransport::sendv( const struct iovec *iov, int count )
+{
+    struct msghdr msg;
+    memset( &msg, 0, sizeof( msg ) );
+    msg.msg_iov = const_cast<struct iovec*>( iov );
+    msg.msg_iovlen = count;
+
+    while ( 1 )
+    {
+        ssize_t n = ::sendmsg( _fd, &msg, MSG_NOSIGNAL );
+        if ( n >= 0 )
+        {
+            return static_cast<size_t>( n );
+        }
+        if ( EINTR == errno )
+        {
+            continue;
+        }
+        if ( EAGAIN != errno && EWOULDBLOCK != errno )
+        {
+            throw _error( "sendmsg" );
+        }
+        _wait( POLLOUT, _sendTimeoutMs, "sendmsg" );
+    }
+}
+
+size_t CRedisPosixTransport::receive( char *pDest, size_t len )
+{
+    while ( 1 )
+    {
+        ssize_t n = ::recv( _fd, pDest, len, 0 );
+        if ( n >= 0 )
+        {
+            return static_cast<size_t>( n );
+        }
+        if ( EINTR == errno )
+        {
+            continue;
+        }
+        if ( EAGAIN != errno && EWOULDBLOCK != errno )
+        {
+            throw _error( "recv" );
+        }
+        _wait( POLLIN, _recvTimeoutMs, "recv" );
+    }
+}
+
+int CRedisPosixTransport::available( void )
+{
+    int n = 0;
+    if ( _fd < 0 || ::ioctl( _fd, FIONREAD, &n ) < 0 )
+    {
+        return 0;
+    }
+    return n;
+}
+
+int CRedisPosixTransport::fd( void ) const
+{
+    return _fd;
+}
+
+void CRedisPosixTransport::_wait( short events, int timeoutMs, const char *what )
+{
+    struct pollfd pfd;
+    pfd.fd = _fd;
+    pfd.events = events;
+    pfd.revents = 0;
+
+    int n = 0;
+    do
+    {
+        n = ::poll( &pfd, 1, timeoutMs );
+    }while ( n < 0 && EINTR == errno );
+
+    if ( n < 0 )
+    {
+        throw _error( what );
+    }
+    if ( 0 == n )
+    {
+        throw ConnectErr( string( what ) + " timeout!" );
+    }
+    // POLLERR, POLLHUP: the next call reports the error.
+}
+
+int CRedisPosixTransport::_toMs( const Timespan &timeout )
+{
+    int64_t us = timeout.totalMicroseconds();
+    if ( us <= 0 )
+    {
+        return -1;
+    }
+    // round up, a timeout under 1ms is not "no timeout".
+    return static_cast<int>( std::min<int64_t>( ( us + 999 ) / 1000, INT_MAX ) );
+}
+
+ConnectErr CRedisPosixTransport::_error( const char *what )
+{
+    return ConnectErr( string( what ) + " exception: " + strerror( errno ) );
+}
+
+//----------------------------------------------poco----------------------------------------------------
+CRedisPocoTransport::CRedisPocoTransport()
+{
+}
+
+CRedisPocoTransport::~CRedisPocoTransport()
+{
+}
+
+CRedisTransport::Type CRedisPocoTransport::type( void ) const
+{
+    return TRANSPORT_POCO;
+}
+
+void CRedisPocoTransport::connect( const SocketAddress &address, const Timespan &timeout )
+{
+    try
+    {
+        _socket.close();
+        _socket.connect( address, timeout );
+    }catch( Poco::Exception& e )
+    {
+        throw ConnectErr( e.displayText() );
+    }
+}
+
+void CRedisPocoTransport::connectUnix( const string &path, const Timespan &timeout )
+{
+    ( void )timeout;
+    throw ConnectErr( "unix socket " + path + " needs CRedisTransport::TRANSPORT_POSIX" );
+}
+
+void CRedisPocoTransport::close( void )
+{
+    _socket.close();
+}
+
+void CRedisPocoTransport::shutdown( void )
+{
+    _socket.shutdown();
+}
+
+void CRedisPocoTransport::setSendTimeout( const Timespan &timeout )
+{
+    _socket.setSendTimeout( timeout );
+}
+
+void CRedisPocoTransport::setReceiveTimeout( const Timespan &timeout )
+{
+    _socket.setReceiveTimeout( timeout );
+}
+
+size_t CRedisPocoTransport::send( const char *data, size_t len )
+{
+    try
+    {
+        int n = _socket.sendBytes( data, static_cast<int>( std::min<size_t>( len, INT_MAX ) ) );
+        return ( n > 0 ) ? static_cast<size_t>( n ) : 0;
+    }catch( Poco::Exception& e )
+    {
+        throw ConnectErr( e.displayText() );
+    }
+}
+
+size_t CRedisPocoTransport::sendv( const struct iovec *iov, int count )
+{
+    struct msghdr msg;
+    memset( &msg, 0, sizeof( msg ) );
+    msg.msg_iov = const_cast<struct iovec*>( iov );
+    msg.msg_iovlen = count;
+
+    ssize_t n = 0;
+    do
+    {
+        n = ::sendmsg( fd(), &msg, MSG_NOSIGNAL );
+    }while ( n < 0 && EINTR == errno );
+
+    if ( n < 0 )
+    {
+        throw ConnectErr( "sendmsg exception!" );
+    }
+    return static_cast<size_t>( n );
+}
+
+size_t CRedisPocoTransport::receive( char *pDest, size_t len )
+{
+    try
+    {
+        int n = _socket.receiveBytes( pDest, static_cast<int>( std::min<size_t>( len, INT_MAX ) ) );
+        return ( n > 0 ) ? static_cast<size_t>( n ) : 0;
+    }catch( Poco::Exception& e )
+    {
+        throw ConnectErr( e.displayText() );
+    }
+}
+
+int CRedisPocoTransport::available( void )
+{
+    try
+    {
+        return _socket.available();
+    }catch( Poco::Exception& )
+    {
+        return 0;
+    }
+}
+
+int CRedisPocoTransport::fd( void ) const
+{
+    return _socket.impl()->sockfd();
+}
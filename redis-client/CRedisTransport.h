@@ -0,0 +1,212 @@
+/**
+ * @file	CRedisTransport.h
+ * @brief CRedisSocket 下层的传输接口：建立连接、收发字节、超时。
+ *
+ * CRedisPosixTransport 直接使用非阻塞 fd、recv/send/sendmsg 与 poll() 超时，错误来自 errno，
+ * 是默认实现；CRedisPocoTransport 保留原来基于 Poco::Net::StreamSocket 的实现。
+ * 两者出错时都抛出 ConnectErr。
+ */
+
+#ifndef CREDISTRANSPORT_H
+#define CREDISTRANSPORT_H
+
+#include <stdint.h>
+#include <sys/uio.h>
+#include <sys/un.h>
+#include <Poco/Timespan.h>
+#include <Poco/Net/SocketAddress.h>
+#include <Poco/Net/StreamSocket.h>
+#include "redisCommon.h"
+#include "RdException.hpp"
+
+using Poco::Net::SocketAddress;
+using Poco::Timespan;
+
+class CRedisTransport
+{
+public:
+    enum Type
+    {
+        TRANSPORT_POSIX,	///< CRedisPosixTransport, the default.
+        TRANSPORT_POCO,		///< CRedisPocoTransport.
+        TRANSPORT_IO_URING	///< CRedisUringTransport, see CRedisUringTransport.h.
+    };
+
+    /**
+     * @brief create
+     * @param bufferSize [in] size of each receive buffer the transport keeps of its own, only
+     * TRANSPORT_IO_URING has some, see CRedisUringTransport. 0: its default.
+     * @return a new transport of type, owned by the caller. TRANSPORT_IO_URING falls back to
+     * TRANSPORT_POSIX when io_uring is not built in or not usable on this kernel, check type().
+     */
+    static CRedisTransport* create( Type type, uint32_t bufferSize = 0 );
+
+    /**
+     * @brief unixAddress fill addr for the unix domain socket at path.
+     * @warning throw ConnectErr when path is empty or too long.
+     */
+    static void unixAddress( const string& path, struct sockaddr_un& addr );
+
+    /**
+     * @brief startConnect open a non-blocking socket and start connecting it to pAddr,
+     * TCP_NODELAY is set for TCP. Shared by the transports and CRedisMultiplexer.
+     * @param connected [out] true: connected already. false: in progress, wait until the fd
+     * is writable, then SO_ERROR tells the result.
+     * @return the fd, closed by the caller.
+     * @warning throw ConnectErr when the socket can not be opened or the connect fails at once.
+     */
+    static int startConnect( const struct sockaddr* pAddr, socklen_t len, bool& connected );
+
+    virtual ~CRedisTransport() {}
+
+    virtual Type type( void ) const = 0;
+
+    /**
+     * @brief connect close the current connection if any, then connect to address.
+     * @param timeout [in] 0: wait as long as it takes.
+     * @warning throw ConnectErr when it can not connect in time.
+     */
+    virtual void connect( const SocketAddress& address, const Timespan& timeout ) = 0;
+
+    /**
+     * @brief connectUnix like connect(), to the unix domain socket at path.
+     * @warning throw ConnectErr when it can not connect in time, or the transport has no unix socket.
+     */
+    virtual void connectUnix( const string& path, const Timespan& timeout ) = 0;
+
+    virtual void close( void ) = 0;
+
+    /**
+     * @brief shutdown stop both directions, a thread blocked in receive() returns.
+     */
+    virtual void shutdown( void ) = 0;
+
+    /**
+     * @brief setSendTimeout
+     * @param timeout [in] 0: no timeout.
+     */
+    virtual void setSendTimeout( const Timespan& timeout ) = 0;
+    virtual void setReceiveTimeout( const Timespan& timeout ) = 0;
+
+    /**
+     * @brief send
+     * @return bytes sent, at least 1, it may be less than len.
+     * @warning throw ConnectErr when the socket fails or times out.
+     */
+    virtual size_t send( const char* data, size_t len ) = 0;
+
+    /**
+     * @brief sendv send several buffers with one sendmsg() call.
+     * @param count [in] number of buffers, no more than IOV_MAX.
+     * @return bytes sent, at least 1, it may be less than the total length of the buffers.
+     * @warning throw ConnectErr when the socket fails or times out.
+     */
+    virtual size_t sendv( const struct iovec* iov, int count ) = 0;
+
+    /**
+     * @brief receive wait for some bytes.
+     * @return bytes received, no more than len. 0: the peer closed the connection.
+     * @warning throw ConnectErr when the socket fails or times out.
+     */
+    virtual size_t receive( char* pDest, size_t len ) = 0;
+
+    /**
+     * @brief available
+     * @return bytes that can be received without waiting.
+     */
+    virtual int available( void ) = 0;
+
+    /**
+     * @brief fd
+     * @return the descriptor of the connection, -1 if not connected.
+     */
+    virtual int fd( void ) const = 0;
+};
+
+/**
+ * @brief The CRedisPosixTransport class calls the socket API directly on a non-blocking fd.
+ * An operation is tried first and poll() is only called when it would block, so a reply
+ * already received costs one recv().
+ */
+class CRedisPosixTransport : public CRedisTransport
+{
+public:
+    CRedisPosixTransport();
+    ~CRedisPosixTransport();
+
+    Type type( void ) const;
+    void connect( const SocketAddress& address, const Timespan& timeout );
+    void connectUnix( const string& path, const Timespan& timeout );
+    void close( void );
+    void shutdown( void );
+    void setSendTimeout( const Timespan& timeout );
+    void setReceiveTimeout( const Timespan& timeout );
+    size_t send( const char* data, size_t len );
+    size_t sendv( const struct iovec* iov, int count );
+    size_t receive( char* pDest, size_t len );
+    int available( void );
+    int fd( void ) const;
+
+protected:
+    /**
+     * @brief _connect open a non-blocking socket and connect it to pAddr.
+     */
+    void _connect( const struct sockaddr* pAddr, socklen_t len, const Timespan& timeout );
+
+    /**
+     * @brief _wait poll() until the fd is ready for events.
+     * @param timeoutMs [in] -1: no timeout.
+     * @warning throw ConnectErr on timeout, what names the operation.
+     */
+    void _wait( short events, int timeoutMs, const char* what );
+
+    /**
+     * @brief _toMs
+     * @return timeout in ms for poll(), -1 for 0.
+     */
+    static int _toMs( const Timespan& timeout );
+
+    /**
+     * @brief _error
+     * @return an exception describing errno.
+     */
+    static ConnectErr _error( const char* what );
+
+    int _fd;
+    int _sendTimeoutMs;			///< -1: no timeout.
+    int _recvTimeoutMs;			///< -1: no timeout.
+
+private:
+    DISALLOW_COPY_AND_ASSIGN( CRedisPosixTransport );
+};
+
+/**
+ * @brief The CRedisPocoTransport class is the Poco::Net::StreamSocket the client used before.
+ * Poco exceptions are turned into ConnectErr. It has no unix domain socket.
+ */
+class CRedisPocoTransport : public CRedisTransport
+{
+public:
+    CRedisPocoTransport();
+    ~CRedisPocoTransport();
+
+    Type type( void ) const;
+    void connect( const SocketAddress& address, const Timespan& timeout );
+    void connectUnix( const string& path, const Timespan& timeout );
+    void close( void );
+    void shutdown( void );
+    void setSendTimeout( const Timespan& timeout );
+    void setReceiveTimeout( const Timespan& timeout );
+    size_t send( const char* data, size_t len );
+    size_t sendv( const struct iovec* iov, int count );
+    size_t receive( char* pDest, size_t len );
+    int available( void );
+    int fd( void ) const;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN( CRedisPocoTransport );
+
+    Poco::Net::StreamSocket _socket;
+};
+
+#endif // CREDISTRANSPORT_H
@@ -0,0 +1,515 @@
+/**
+ * @file	CRedisUringTransport.cpp
+ * @brief 基于 io_uring 的传输。
+ */
+
+#include "CRedisUringTransport.h"
+
+#ifdef CREDIS_HAVE_IO_URING
+
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <algorithm>
+#include <chrono>
+
+CRedisUringTransport::CRedisUringTransport( uint32_t bufferSize ):
+    _ringFd( -1 ),
+    _pRing( MAP_FAILED ),
+    _ringSize( 0 ),
+    _pSqes( static_cast<struct io_uring_sqe*>( MAP_FAILED ) ),
+    _sqesSize( 0 ),
+    _pSqHead( NULL ),
+    _pSqTail( NULL ),
+    _pSqArray( NULL ),
+    _sqMask( 0 ),
+    _sqEntries( 0 ),
+    _pCqHead( NULL ),
+    _pCqTail( NULL ),
+    _pCqes( NULL ),
+    _cqMask( 0 ),
+    _toSubmit( 0 ),
+    _pBufRing( static_cast<struct io_uring_buf_ring*>( MAP_FAILED ) ),
+    _pBuffers( NULL ),
+    _bufferSize( 0 == bufferSize ? static_cast<uint32_t>( RECV_BUFFER_SIZE ) : bufferSize ),
+    _bufTail( 0 ),
+    _armed( false ),
+    _sendDone( false ),
+    _sendResult( 0 )
+{
+    memset( &_msg, 0, sizeof( _msg ) );
+    try
+    {
+        _setup();
+    }catch( ... )
+    {
+        _destroy();
+        throw;
+    }
+}
+
+CRedisUringTransport::~CRedisUringTransport()
+{
+    try
+    {
+        close();
+    }catch( ... )
+    {
+        // the ring is torn down below, the kernel cancels what is left.
+    }
+    _destroy();
+}
+
+bool CRedisUringTransport::supported( void )
+{
+    static const bool s_supported = _probe();
+    return s_supported;
+}
+
+CRedisTransport::Type CRedisUringTransport::type( void ) const
+{
+    return TRANSPORT_IO_URING;
+}
+
+void CRedisUringTransport::connect( const SocketAddress &address, const Timespan &timeout )
+{
+    CRedisPosixTransport::connect( address, timeout );
+    _attached();
+}
+
+void CRedisUringTransport::connectUnix( const string &path, const Timespan &timeout )
+{
+    CRedisPosixTransport::connectUnix( path, timeout );
+    _attached();
+}
+
+void CRedisUringTransport::close( void )
+{
+    if ( _armed )
+    {
+        // the recv holds the socket, it is not closed until the recv ends.
+        _cancel( TAG_RECV );
+    }
+    for ( std::deque<Chunk>::iterator it = _chunks.begin(); it != _chunks.end(); ++it )
+    {
+        if ( it->res > 0 )
+        {
+            _recycle( it->bid );
+        }
+    }
+    _chunks.clear();
+    CRedisPosixTransport::close();
+}
+
+void CRedisUringTransport::attach( int fd )
+{
+    close();
+    _fd = fd;
+    _attached();
+}
+
+size_t CRedisUringTransport::send( const char *data, size_t len )
+{
+    struct iovec iov;
+    iov.iov_base = const_cast<char*>( data );
+    iov.iov_len = len;
+    return sendv( &iov, 1 );
+}
+
+size_t CRedisUringTransport::sendv( const struct iovec *iov, int count )
+{
+    memset( &_msg, 0, sizeof( _msg ) );
+    _msg.msg_iov = const_cast<struct iovec*>( iov );
+    _msg.msg_iovlen = count;
+    return _sendmsg();
+}
+
+size_t CRedisUringTransport::receive( char *pDest, size_t len )
+{
+    int64_t deadline = _deadline( _recvTimeoutMs );
+    _reap();
+    while ( _chunks.empty() )
+    {
+        if ( !_armed )
+        {
+            _armRecv();
+        }
+        if ( !_enter( 1, deadline ) )
+        {
+            throw ConnectErr( "recv timeout!" );
+        }
+        _reap();
+    }
+
+    size_t got = 0;
+    while ( got < len && !_chunks.empty() )
+    {
+        Chunk& chunk = _chunks.front();
+        if ( chunk.res <= 0 )
+        {
+            if ( got > 0 )
+            {
+                // hand over the bytes first, the end of the stream comes with the next call.
+                break;
+            }
+            int res = chunk.res;
+            _chunks.pop_front();
+            if ( 0 == res )
+            {
+                return 0;
+            }
+            errno = -res;
+            throw _error( "recv" );
+        }
+
+        size_t n = std::min<size_t>( len - got, chunk.res - chunk.offset );
+        memcpy( pDest + got, _pBuffers + chunk.bid * _bufferSize + chunk.offset, n );
+        got += n;
+        chunk.offset += n;
+        if ( chunk.offset == static_cast<uint32_t>( chunk.res ) )
+        {
+            _recycle( chunk.bid );
+            _chunks.pop_front();
+        }
+    }
+    return got;
+}
+
+int CRedisUringTransport::available( void )
+{
+    _reap();
+    int n = 0;
+    for ( std::deque<Chunk>::const_iterator it = _chunks.begin(); it != _chunks.end(); ++it )
+    {
+        if ( it->res > 0 )
+        {
+            n += it->res - it->offset;
+        }
+    }
+    return n + CRedisPosixTransport::available();
+}
+
+//----------------------------------------------private----------------------------------------------------
+void CRedisUringTransport::_setup( void )
+{
+    struct io_uring_params params;
+    memset( &params, 0, sizeof( params ) );
+    _ringFd = static_cast<int>( ::syscall( __NR_io_uring_setup, RING_ENTRIES, &params ) );
+    if ( _ringFd < 0 )
+    {
+        throw _error( "io_uring_setup" );
+    }
+    if ( !( params.features & IORING_FEAT_SINGLE_MMAP ) || !( params.features & IORING_FEAT_EXT_ARG ) )
+    {
+        throw ConnectErr( "io_uring is too old" );
+    }
+
+    size_t sqSize = params.sq_off.array + params.sq_entries * sizeof( uint32_t );
+    size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof( struct io_uring_cqe );
+    _ringSize = std::max( sqSize, cqSize );
+    _pRing = ::mmap( NULL, _ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQ_RING );
+    if ( MAP_FAILED == _pRing )
+    {
+        throw _error( "io_uring mmap" );
+    }
+    _sqesSize = params.sq_entries * sizeof( struct io_uring_sqe );
+    void* pSqes = ::mmap( NULL, _sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _ringFd, IORING_OFF_SQES );
+    if ( MAP_FAILED == pSqes )
+    {
+        throw _error( "io_uring mmap" );
+    }
+    _pSqes = static_cast<struct io_uring_sqe*>( pSqes );
+
+    char* pRing = static_cast<char*>( _pRing );
+    _pSqHead = reinterpret_cast<uint32_t*>( pRing + params.sq_off.head );
+    _pSqTail = reinterpret_cast<uint32_t*>( pRing + params.sq_off.tail );
+    _pSqArray = reinterpret_cast<uint32_t*>( pRing + params.sq_off.array );
+    _sqMask = *reinterpret_cast<uint32_t*>( pRing + params.sq_off.ring_mask );
+    _sqEntries = params.sq_entries;
+    _pCqHead = reinterpret_cast<uint32_t*>( pRing + params.cq_off.head );
+    _pCqTail = reinterpret_cast<uint32_t*>( pRing + params.cq_off.tail );
+    _pCqes = reinterpret_cast<struct io_uring_cqe*>( pRing + params.cq_off.cqes );
+    _cqMask = *reinterpret_cast<uint32_t*>( pRing + params.cq_off.ring_mask );
+
+    // the buffer ring must be page aligned.
+    void* pBufRing = ::mmap( NULL, RECV_BUFFER_NUM * sizeof( struct io_uring_buf ), PROT_READ | PROT_WRITE,
+                             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+    if ( MAP_FAILED == pBufRing )
+    {
+        throw _error( "io_uring mmap" );
+    }
+    _pBufRing = static_cast<struct io_uring_buf_ring*>( pBufRing );
+    struct io_uring_buf_reg reg;
+    memset( &reg, 0, sizeof( reg ) );
+    reg.ring_addr = reinterpret_cast<uint64_t>( _pBufRing );
+    reg.ring_entries = RECV_BUFFER_NUM;
+    reg.bgid = BUFFER_GROUP;
+    if ( ::syscall( __NR_io_uring_register, _ringFd, IORING_REGISTER_PBUF_RING, &reg, 1 ) < 0 )
+    {
+        throw _error( "io_uring_register" );
+    }
+
+    _pBuffers = new char[RECV_BUFFER_NUM * static_cast<size_t>( _bufferSize )];
+    for ( uint16_t bid = 0; bid < RECV_BUFFER_NUM; ++bid )
+    {
+        _recycle( bid );
+    }
+}
+
+void CRedisUringTransport::_destroy( void )
+{
+    // closing the ring drops the registered buffer ring too.
+    if ( _ringFd >= 0 )
+    {
+        ::close( _ringFd );
+        _ringFd = -1;
+    }
+    if ( MAP_FAILED != _pRing )
+    {
+        ::munmap( _pRing, _ringSize );
+        _pRing = MAP_FAILED;
+    }
+    if ( MAP_FAILED != static_cast<void*>( _pSqes ) )
+    {
+        ::munmap( _pSqes, _sqesSize );
+        _pSqes = static_cast<struct io_uring_sqe*>( MAP_FAILED );
+    }
+    if ( MAP_FAILED != static_cast<void*>( _pBufRing ) )
+    {
+        ::munmap( _pBufRing, RECV_BUFFER_NUM * sizeof( struct io_uring_buf ) );
+        _pBufRing = static_cast<struct io_uring_buf_ring*>( MAP_FAILED );
+    }
+    delete [] _pBuffers;
+    _pBuffers = NULL;
+}
+
+void CRedisUringTransport::_attached( void )
+{
+    // with O_NONBLOCK io_uring would fail with EAGAIN instead of waiting for the socket.
+    int flags = ::fcntl( _fd, F_GETFL );
+    if ( flags < 0 || ::fcntl( _fd, F_SETFL, flags & ~O_NONBLOCK ) < 0 )
+    {
+        ConnectErr err = _error( "fcntl" );
+        CRedisPosixTransport::close();
+        throw err;
+    }
+}
+
+struct io_uring_sqe *CRedisUringTransport::_getSqe( void )
+{
+    uint32_t tail = *_pSqTail;
+    if ( tail - __atomic_load_n( _pSqHead, __ATOMIC_ACQUIRE ) >= _sqEntries )
+    {
+        throw ConnectErr( "io_uring submission queue is full!" );
+    }
+    uint32_t index = tail & _sqMask;
+    struct io_uring_sqe* pSqe = &_pSqes[index];
+    memset( pSqe, 0, sizeof( *pSqe ) );
+    _pSqArray[index] = index;
+    return pSqe;
+}
+
+bool CRedisUringTransport::_enter( uint32_t minComplete, int64_t deadline )
+{
+    while ( 1 )
+    {
+        struct __kernel_timespec ts;
+        struct io_uring_getevents_arg arg;
+        memset( &arg, 0, sizeof( arg ) );
+        void* pArg = NULL;
+        size_t argSize = 0;
+        uint32_t flags = ( minComplete > 0 ) ? IORING_ENTER_GETEVENTS : 0;
+        if ( deadline >= 0 && minComplete > 0 )
+        {
+            int64_t left = deadline - _deadline( 0 );
+            if ( left <= 0 )
+            {
+                return false;
+            }
+            ts.tv_sec = left / 1000;
+            ts.tv_nsec = ( left % 1000 ) * 1000000;
+            arg.ts = reinterpret_cast<uint64_t>( &ts );
+            pArg = &arg;
+            argSize = sizeof( arg );
+            flags |= IORING_ENTER_EXT_ARG;
+        }
+
+        long ret = ::syscall( __NR_io_uring_enter, _ringFd, _toSubmit, minComplete, flags, pArg, argSize );
+        if ( ret >= 0 )
+        {
+            _toSubmit -= std::min<uint32_t>( static_cast<uint32_t>( ret ), _toSubmit );
+            return true;
+        }
+        if ( ETIME == errno )
+        {
+            return false;
+        }
+        if ( EBUSY == errno || EAGAIN == errno )
+        {
+            // the completion queue overflowed, make room and wait again.
+            _reap();
+            return true;
+        }
+        if ( EINTR != errno )
+        {
+            throw _error( "io_uring_enter" );
+        }
+    }
+}
+
+void CRedisUringTransport::_reap( void )
+{
+    uint32_t head = *_pCqHead;
+    uint32_t tail = __atomic_load_n( _pCqTail, __ATOMIC_ACQUIRE );
+    for ( ; head != tail; ++head )
+    {
+        const struct io_uring_cqe& cqe = _pCqes[head & _cqMask];
+        if ( TAG_RECV == cqe.user_data )
+        {
+            if ( !( cqe.flags & IORING_CQE_F_MORE ) )
+            {
+                _armed = false;
+            }
+            if ( -ENOBUFS == cqe.res )
+            {
+                // every buffer is full, the bytes wait in the socket until the recv is armed again.
+                continue;
+            }
+            Chunk chunk;
+            chunk.res = cqe.res;
+            chunk.bid = static_cast<uint16_t>( cqe.flags >> IORING_CQE_BUFFER_SHIFT );
+            chunk.offset = 0;
+            _chunks.push_back( chunk );
+        }else if ( TAG_SEND == cqe.user_data )
+        {
+            _sendDone = true;
+            _sendResult = cqe.res;
+        }
+        // TAG_CANCEL: the cancelled request reports on its own.
+    }
+    __atomic_store_n( _pCqHead, head, __ATOMIC_RELEASE );
+}
+
+void CRedisUringTransport::_armRecv( void )
+{
+    struct io_uring_sqe* pSqe = _getSqe();
+    pSqe->opcode = IORING_OP_RECV;
+    pSqe->fd = _fd;
+    pSqe->flags = IOSQE_BUFFER_SELECT;
+    pSqe->buf_group = BUFFER_GROUP;
+    pSqe->ioprio = IORING_RECV_MULTISHOT;
+    pSqe->user_data = TAG_RECV;
+    __atomic_store_n( _pSqTail, *_pSqTail + 1, __ATOMIC_RELEASE );
+    ++_toSubmit;
+    _armed = true;
+}
+
+void CRedisUringTransport::_cancel( uint64_t tag )
+{
+    struct io_uring_sqe* pSqe = _getSqe();
+    pSqe->opcode = IORING_OP_ASYNC_CANCEL;
+    pSqe->fd = -1;
+    pSqe->addr = tag;
+    pSqe->user_data = TAG_CANCEL;
+    __atomic_store_n( _pSqTail, *_pSqTail + 1, __ATOMIC_RELEASE );
+    ++_toSubmit;
+
+    while ( TAG_RECV == tag ? _armed : !_sendDone )
+    {
+        _enter( 1, -1 );
+        _reap();
+    }
+}
+
+void CRedisUringTransport::_recycle( uint16_t bid )
+{
+    // not _pBufRing->bufs: in C++ the empty struct of __DECLARE_FLEX_ARRAY moves it 8 bytes on.
+    struct io_uring_buf* pBufs = reinterpret_cast<struct io_uring_buf*>( _pBufRing );
+    struct io_uring_buf& buf = pBufs[_bufTail & ( RECV_BUFFER_NUM - 1 )];
+    buf.addr = reinterpret_cast<uint64_t>( _pBuffers + bid * static_cast<size_t>( _bufferSize ) );
+    buf.len = _bufferSize;
+    buf.bid = bid;
+    ++_bufTail;
+    __atomic_store_n( &_pBufRing->tail, _bufTail, __ATOMIC_RELEASE );
+}
+
+size_t CRedisUringTransport::_sendmsg( void )
+{
+    struct io_uring_sqe* pSqe = _getSqe();
+    pSqe->opcode = IORING_OP_SENDMSG;
+    pSqe->fd = _fd;
+    pSqe->addr = reinterpret_cast<uint64_t>( &_msg );
+    pSqe->len = 1;
+    // MSG_WAITALL: the kernel retries a short send itself.
+    pSqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    pSqe->user_data = TAG_SEND;
+    __atomic_store_n( _pSqTail, *_pSqTail + 1, __ATOMIC_RELEASE );
+    ++_toSubmit;
+    _sendDone = false;
+
+    // a reply of the previous request may complete first, _reap() keeps it.
+    int64_t deadline = _deadline( _sendTimeoutMs );
+    while ( !_sendDone )
+    {
+        if ( !_enter( 1, deadline ) )
+        {
+            // _msg must stay valid until the kernel lets go of it.
+            _cancel( TAG_SEND );
+            if ( _sendResult <= 0 )
+            {
+                throw ConnectErr( "sendmsg timeout!" );
+            }
+            break;
+        }
+        _reap();
+    }
+    if ( _sendResult < 0 )
+    {
+        errno = -_sendResult;
+        throw _error( "sendmsg" );
+    }
+    return static_cast<size_t>( _sendResult );
+}
+
+int64_t CRedisUringTransport::_deadline( int timeoutMs )
+{
+    if ( timeoutMs < 0 )
+    {
+        return -1;
+    }
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now().time_since_epoch() ).count() + timeoutMs;
+}
+
+bool CRedisUringTransport::_probe( void )
+{
+    int sv[2];
+    if ( ::socketpair( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv ) < 0 )
+    {
+        return false;
+    }
+    bool ok = false;
+    try
+    {
+        CRedisUringTransport transport;
+        transport.attach( sv[0] );
+        transport._recvTimeoutMs = 1000;
+        char ch = 0;
+        if ( 1 == ::write( sv[1], "+", 1 ) && 1 == transport.receive( &ch, 1 ) )
+        {
+            // an old kernel ends the recv after one completion, or refuses the flag.
+            ok = ( '+' == ch && transport._armed );
+        }
+        transport.close();
+    }catch( ... )
+    {
+        ok = false;
+    }
+    ::close( sv[1] );
+    return ok;
+}
+
+#endif // CREDIS_HAVE_IO_URING
@@ -0,0 +1,172 @@
+/**
+ * @file	CRedisUringTransport.h
+ * @brief 基于 io_uring 的传输：multishot recv 收到内核登记的缓冲区中，sendmsg 与等待在一次
+ * io_uring_enter() 中完成。直接使用系统调用，不依赖 liburing。
+ *
+ * 回复已经到达时 receive() 不需要任何系统调用，只读取完成队列。
+ * 编译时没有 <linux/io_uring.h>、定义了 CREDIS_NO_IO_URING，或内核不支持 multishot recv
+ * 时，CRedisTransport::create( TRANSPORT_IO_URING ) 返回 CRedisPosixTransport。
+ */
+
+#ifndef CREDISURINGTRANSPORT_H
+#define CREDISURINGTRANSPORT_H
+
+#include "CRedisTransport.h"
+
+#if defined( __linux__ ) && !defined( CREDIS_NO_IO_URING ) && defined( __has_include )
+#if __has_include( <linux/io_uring.h> )
+#include <linux/io_uring.h>
+#ifdef IORING_RECV_MULTISHOT
+#define CREDIS_HAVE_IO_URING
+#endif
+#endif
+#endif
+
+#ifdef CREDIS_HAVE_IO_URING
+
+#include <deque>
+#include <sys/socket.h>
+
+/**
+ * @brief The CRedisUringTransport class connects like CRedisPosixTransport, then moves the data
+ * through a small io_uring of its own. A multishot recv stays armed on the socket, so bytes
+ * arriving are written into a ring of provided buffers without being asked for.
+ *
+ * Each transport is one io_uring instance: about 12 KB for the queues and the buffer ring,
+ * plus RECV_BUFFER_NUM provided buffers. CRedisSocket sizes them like its receive buffer at
+ * rest, 8 KB in all with the default 1 KB, so 2,000 pooled connections hold about 40 MB and
+ * 2,000 rings. A reply longer than the provided buffers stops the multishot recv with ENOBUFS,
+ * it is armed again once they are consumed: a larger initSize of CRedisClient::setRecvBuffer()
+ * takes fewer io_uring_enter() for large replies and 8 times its size per connection.
+ */
+class CRedisUringTransport : public CRedisPosixTransport
+{
+public:
+    enum
+    {
+        RING_ENTRIES = 8,				///< submission queue size, a request needs 2 at most.
+        RECV_BUFFER_NUM = 8,			///< provided buffers, a power of 2.
+        RECV_BUFFER_SIZE = 1024			///< default size of each provided buffer, as CRedisSocket::RECEIVE_BUFFER_SIZE.
+    };
+
+    /**
+     * @brief CRedisUringTransport
+     * @param bufferSize [in] size of each of the RECV_BUFFER_NUM provided buffers, 0: RECV_BUFFER_SIZE.
+     * @warning throw ConnectErr when the ring can not be set up.
+     */
+    explicit CRedisUringTransport( uint32_t bufferSize = RECV_BUFFER_SIZE );
+    ~CRedisUringTransport();
+
+    /**
+     * @brief supported
+     * @return true: this kernel has io_uring with provided buffer rings and multishot recv.
+     * Checked once on a socketpair.
+     */
+    static bool supported( void );
+
+    Type type( void ) const;
+    void connect( const SocketAddress& address, const Timespan& timeout );
+    void connectUnix( const string& path, const Timespan& timeout );
+    void close( void );
+
+    /**
+     * @brief attach take over fd, a connected stream socket, eg: one end of a socketpair().
+     * It is closed by close().
+     * @warning throw ConnectErr when fd can not be made blocking, fd is closed then.
+     */
+    void attach( int fd );
+
+    size_t send( const char* data, size_t len );
+    size_t sendv( const struct iovec* iov, int count );
+    size_t receive( char* pDest, size_t len );
+    int available( void );
+
+private:
+    DISALLOW_COPY_AND_ASSIGN( CRedisUringTransport );
+
+    enum
+    {
+        TAG_RECV = 1,		///< user_data of the multishot recv.
+        TAG_SEND,			///< user_data of sendmsg.
+        TAG_CANCEL,			///< user_data of a cancellation.
+        BUFFER_GROUP = 0	///< group of the provided buffers, the ring is not shared.
+    };
+
+    ///< a completion of the multishot recv not consumed yet.
+    struct Chunk
+    {
+        int res;			///< bytes received, 0: the peer closed, < 0: -errno.
+        uint16_t bid;		///< buffer holding the bytes.
+        uint32_t offset;	///< bytes already handed out.
+    };
+
+    void _setup( void );
+    void _destroy( void );
+
+    /**
+     * @brief _attached the fd is connected: make it blocking, io_uring waits for it, not poll().
+     */
+    void _attached( void );
+
+    struct io_uring_sqe* _getSqe( void );
+
+    /**
+     * @brief _enter submit the queued entries and wait for minComplete completions.
+     * @param deadline [in] steady clock in ms, -1: no timeout.
+     * @return false: the deadline passed.
+     */
+    bool _enter( uint32_t minComplete, int64_t deadline );
+
+    /**
+     * @brief _reap take the completions out of the completion queue.
+     */
+    void _reap( void );
+
+    void _armRecv( void );
+
+    /**
+     * @brief _cancel cancel the request tagged tag, then wait until its last completion.
+     */
+    void _cancel( uint64_t tag );
+
+    /**
+     * @brief _recycle give a provided buffer back to the kernel.
+     */
+    void _recycle( uint16_t bid );
+
+    size_t _sendmsg( void );
+
+    static int64_t _deadline( int timeoutMs );
+    static bool _probe( void );
+
+    int _ringFd;
+    void* _pRing;					///< sq and cq rings, one mapping.
+    size_t _ringSize;
+    struct io_uring_sqe* _pSqes;
+    size_t _sqesSize;
+    uint32_t* _pSqHead;
+    uint32_t* _pSqTail;
+    uint32_t* _pSqArray;
+    uint32_t _sqMask;
+    uint32_t _sqEntries;
+    uint32_t* _pCqHead;
+    uint32_t* _pCqTail;
+    struct io_uring_cqe* _pCqes;
+    uint32_t _cqMask;
+    uint32_t _toSubmit;			///< entries queued but not submitted yet.
+
+    struct io_uring_buf_ring* _pBufRing;
+    char* _pBuffers;				///< RECV_BUFFER_NUM buffers of _bufferSize.
+    uint32_t _bufferSize;			///< size of each provided buffer.
+    uint16_t _bufTail;
+
+    bool _armed;					///< the multishot recv is active.
+    std::deque<Chunk> _chunks;
+    bool _sendDone;
+    int _sendResult;
+    struct msghdr _msg;			///< read by the kernel until sendmsg completes.
+};
+
+#endif // CREDIS_HAVE_IO_URING
+
+#endif // CREDISURINGTRANSPORT_H
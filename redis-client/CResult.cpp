@@ -1,6 +1,7 @@
 #include "CResult.h"
 #include <sstream>
 #include "RdException.hpp"
+#include "RdNumeric.h"
 
 CResult::CResult():
    _type( REDIS_REPLY_NIL )
@@ -22,6 +23,20 @@ CResult::CResult(const std::string &value):
     _arry.clear();
 }
 
+CResult::CResult( CResult &&other ) noexcept:
+    std::string( std::move( other ) ),
+    _type( other._type ),
+    _arry( std::move( other._arry ) )
+{
+    other._type = REDIS_REPLY_NIL;
+}
+
+CResult::CResult( std::string &&value ):
+    std::string( std::move( value ) ),
+    _type( REDIS_REPLY_NIL )
+{
+}
+
 CResult::~CResult()
 {
 
@@ -37,9 +52,15 @@ ReplyType CResult::getType() const
     return _type;
 }
 
+bool CResult::isAggregate( void ) const
+{
+    return REDIS_REPLY_ARRAY == _type || REDIS_REPLY_MAP == _type ||
+            REDIS_REPLY_SET == _type || REDIS_REPLY_PUSH == _type;
+}
+
 bool CResult::addElement(const CResult &ele)
 {
-    if ( _type != REDIS_REPLY_ARRAY )
+    if ( !isAggregate() )
     {
         return false;
     }
@@ -48,9 +69,44 @@ bool CResult::addElement(const CResult &ele)
     return true;
 }
 
+bool CResult::addElement( CResult &&ele )
+{
+    if ( !isAggregate() )
+    {
+        return false;
+    }
+
+    _arry.emplace_back( std::move( ele ) );
+    return true;
+}
+
+CResult &CResult::newElement( void )
+{
+    if ( !isAggregate() )
+    {
+        throw TypeErr( "Data is not arry type" );
+    }
+    _arry.emplace_back();
+    return _arry.back();
+}
+
+void CResult::reserveElements( size_t num )
+{
+    _arry.reserve( num );
+}
+
 const CResult::ListCResult &CResult::getArry( void ) const
 {
-    if ( _type != REDIS_REPLY_ARRAY )
+    if ( !isAggregate() )
+    {
+        throw TypeErr( "Data is not arry type" );
+    }
+    return _arry;
+}
+
+CResult::ListCResult &CResult::getArry( void )
+{
+    if ( !isAggregate() )
     {
         throw TypeErr( "Data is not arry type" );
     }
@@ -64,11 +120,8 @@ int64_t CResult::getInt(void) const
          throw TypeErr( "Data is not int type" );
     }
 
-    int64_t value;
-    std::istringstream istr( std::string(*this) );
-    istr >> value;
-
-    if ( istr.fail() )
+    int64_t value = 0;
+    if ( !RdNumeric::parseInt( data(), size(), value ) )
     {
          throw TypeErr( "Data is not int type" );
     }
@@ -103,13 +156,58 @@ string CResult::getStatus( void ) const
     return *this;
 }
 
+double CResult::getDouble( void ) const
+{
+    if ( _type != REDIS_REPLY_DOUBLE )
+    {
+         throw TypeErr( "Data is not double type" );
+    }
+    double value = 0;
+    if ( !RdNumeric::parseDouble( data(), size(), value ) )
+    {
+         throw TypeErr( "Data is not double type" );
+    }
+    return value;
+}
+
+bool CResult::getBool( void ) const
+{
+    if ( _type != REDIS_REPLY_BOOL )
+    {
+         throw TypeErr( "Data is not bool type" );
+    }
+    return "t" == *this;
+}
+
+string CResult::getBigNumber( void ) const
+{
+    if ( _type != REDIS_REPLY_BIGNUM )
+    {
+         throw TypeErr( "Data is not big number type" );
+    }
+    return *this;
+}
+
+string CResult::getVerbatim( string *format ) const
+{
+    if ( _type != REDIS_REPLY_VERB || size() < 4 || ':' != at( 3 ) )
+    {
+         throw TypeErr( "Data is not verbatim string type" );
+    }
+    if ( NULL != format )
+    {
+        format->assign( *this, 0, 3 );
+    }
+    return substr( 4 );
+}
+
 
 std::string CResult::display( const CResult &ele, int indent )
 {
     ReplyType e = ele.getType( );
     string type =CResult::getTypeString( e );
     std::stringstream out;
-    if ( REDIS_REPLY_ARRAY == e )
+    if ( ele.isAggregate() )
     {
        CResult::ListCResult::const_iterator it = ele.getArry().begin() ;
         indent += 3;
@@ -173,6 +271,26 @@ CResult &CResult::operator=( const CResult &other)
     return *this;
 }
 
+CResult &CResult::operator=( std::string &&value )
+{
+    string::assign( std::move( value ) );
+    return *this;
+}
+
+CResult &CResult::operator=( CResult &&other ) noexcept
+{
+    if ( this == &other )
+    {
+        return *this;
+    }
+
+    _type = other._type;
+    string::assign( std::move( other ) );
+    _arry = std::move( other._arry );
+    other._type = REDIS_REPLY_NIL;
+    return *this;
+}
+
 void CResult::clear()
 {
     _type = REDIS_REPLY_NIL;
@@ -204,6 +322,27 @@ string CResult::getTypeString( ReplyType e )
     case REDIS_REPLY_STRING :
         type = "REPLY_STRING";
         break;
+    case REDIS_REPLY_DOUBLE :
+        type = "REPLY_DOUBLE";
+        break;
+    case REDIS_REPLY_BOOL :
+        type = "REPLY_BOOL";
+        break;
+    case REDIS_REPLY_BIGNUM :
+        type = "REPLY_BIGNUM";
+        break;
+    case REDIS_REPLY_VERB :
+        type = "REPLY_VERB";
+        break;
+    case REDIS_REPLY_MAP :
+        type = "REPLY_MAP";
+        break;
+    case REDIS_REPLY_SET :
+        type = "REPLY_SET";
+        break;
+    case REDIS_REPLY_PUSH :
+        type = "REPLY_PUSH";
+        break;
     default:
         type = "REPLY_UNKNOW";
         break;
@@ -1,6 +1,7 @@
 #ifndef CRESULT_H
 #define CRESULT_H
 
+#include <vector>
 #include "redisCommon.h"
 
 
@@ -11,14 +12,23 @@ typedef enum ReplyType
     REDIS_REPLY_INTEGERER,
     REDIS_REPLY_NIL,
     REDIS_REPLY_STATUS,
-    REDIS_REPLY_ERROR
+    REDIS_REPLY_ERROR,
+    //------RESP3, only after HELLO 3.
+    REDIS_REPLY_DOUBLE,		///< ",", see getDouble().
+    REDIS_REPLY_BOOL,		///< "#", see getBool().
+    REDIS_REPLY_BIGNUM,		///< "(", the decimal digits, see getBigNumber().
+    REDIS_REPLY_VERB,		///< "=", "fmt:" followed by the text, see getVerbatim().
+    REDIS_REPLY_MAP,		///< "%", keys and values alternate in getArry().
+    REDIS_REPLY_SET,		///< "~", elements in getArry().
+    REDIS_REPLY_PUSH		///< ">", out of band data, elements in getArry().
 } ReplyType;
 
 class CResult : public std::string
 {
 public:
 
-    typedef std::list<CResult> ListCResult;
+    ///< elements of an array are stored contiguously, they are constructed in place by newElement().
+    typedef std::vector<CResult> ListCResult;
 
     CResult();
 
@@ -26,6 +36,13 @@ public:
 
     CResult( const string& value );
 
+    /**
+     * @brief CResult the payload and the elements of other are taken over, not copied.
+     */
+    CResult( CResult&& other ) noexcept;
+
+    CResult( string&& value );
+
     ~CResult();
 
     void setType( const ReplyType e );
@@ -33,10 +50,33 @@ public:
 
     ReplyType getType( void ) const ;
 
+    /**
+     * @brief isAggregate
+     * @return true: it has elements, an array, a map, a set or a push.
+     */
+    bool isAggregate( void ) const;
+
     bool addElement(const CResult &ele);
+    bool addElement( CResult&& ele );
+
+    /**
+     * @brief newElement append an empty element to an array, it is filled in place.
+     * @return the element appended.
+     */
+    CResult& newElement( void );
+
+    /**
+     * @brief reserveElements make room for num elements, so appending them does not reallocate.
+     */
+    void reserveElements( size_t num );
 
     const ListCResult &getArry( void ) const;
 
+    /**
+     * @brief getArry the elements may be moved out, eg: std::move( result.getArry() ).
+     */
+    ListCResult &getArry( void );
+
     int64_t getInt( void ) const;
 
     string getString( void )const;
@@ -45,6 +85,19 @@ public:
 
     string getStatus( void ) const;
 
+    double getDouble( void ) const;
+
+    bool getBool( void ) const;
+
+    string getBigNumber( void ) const;
+
+    /**
+     * @brief getVerbatim
+     * @param format [out] the 3 characters format of the text, eg: "txt", "mkd".
+     * @return the text without the format.
+     */
+    string getVerbatim( string* format = NULL ) const;
+
     static string display(const CResult &ele, int indent );
 
 
@@ -52,6 +105,8 @@ public:
 
     CResult& operator= ( const string& value );
     CResult& operator= ( const CResult& other );
+    CResult& operator= ( string&& value );
+    CResult& operator= ( CResult&& other ) noexcept;
 
 
 
@@ -0,0 +1,165 @@
+/**
+ * @file	CStringsHandler.h
+ * @brief 把数组回复逐个元素流式存入 VecString 或 TupleString，不构建 CResult。
+ *
+ * CRedisClient::_getArry 内部使用，单独成文件便于不连接 redis 直接测试。
+ */
+
+#ifndef CSTRINGSHANDLER_H
+#define CSTRINGSHANDLER_H
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "CRedisParser.h"
+#include "RdNumeric.h"
+
+/**
+ * @brief The CStringsHandler class streams the elements of an array reply into a VecString,
+ * or into a TupleString two by two, without building a CResult for it.
+ * For pairs an element that is an array of 2 gives the key and the value, that is how
+ * RESP3 replies WITHSCORES: *1\r\n*2\r\n$1\r\na\r\n,1.5\r\n is the pair ( "a", "1.5" ).
+ */
+class CStringsHandler : public CRedisReplyHandler
+{
+public:
+    typedef std::vector<std::string> VecString;						///< same as CRedisClient::VecString.
+    typedef std::vector<std::tuple<std::string,std::string>> TupleString;	///< same as CRedisClient::TupleString.
+
+    CStringsHandler( VecString* pValues, TupleString* pPairs ):
+        _pValues( pValues ),
+        _pPairs( pPairs ),
+        _depth( 0 ),
+        _count( 0 ),
+        _isArray( false ),
+        _isNil( false ),
+        _hasKey( false ),
+        _inPair( false )
+    {
+    }
+
+    virtual bool onArrayBegin( int64_t size )
+    {
+        if ( 0 == _depth )
+        {
+            _isArray = true;
+            size = std::min<int64_t>( size, MAX_RESERVE );
+            if ( NULL != _pValues )
+            {
+                _pValues->reserve( _pValues->size() + size );
+            }else
+            {
+                _pPairs->reserve( _pPairs->size() + size / 2 );
+            }
+        }else if ( 1 == _depth )
+        {
+            if ( NULL != _pPairs && 2 == size )
+            {
+                // its two elements are handed over as the key and the value.
+                _inPair = true;
+            }else
+            {
+                // an element that is an array is taken as an empty string, like CResult does.
+                _element( "", 0 );
+            }
+        }
+        ++_depth;
+        return true;
+    }
+
+    virtual bool onArrayEnd( void )
+    {
+        --_depth;
+        if ( 1 == _depth )
+        {
+            _inPair = false;
+        }
+        return true;
+    }
+
+    virtual bool onBulk( const char* data, size_t len )
+    {
+        return _value( data, len );
+    }
+
+    virtual bool onInt( int64_t value )
+    {
+        char tmp[RdNumeric::MAX_INT_SIZE];
+        return _value( tmp, RdNumeric::formatInt( value, tmp ) );
+    }
+
+    virtual bool onStatus( const char* data, size_t len )
+    {
+        return _value( data, len );
+    }
+
+    virtual bool onError( const char* data, size_t len )
+    {
+        if ( 0 == _depth )
+        {
+            _error.assign( data, len );
+        }
+        return _value( data, len );
+    }
+
+    virtual bool onNil( void )
+    {
+        if ( 0 == _depth )
+        {
+            _isNil = true;
+        }
+        return _value( "", 0 );
+    }
+
+    bool isArray( void ) const { return _isArray; }
+    bool isNil( void ) const { return _isNil; }
+    bool isError( void ) const { return !_error.empty(); }
+    const std::string& getError( void ) const { return _error; }
+    uint64_t getCount( void ) const { return _count; }
+
+private:
+    enum
+    {
+        MAX_RESERVE = 1024 * 1024		///< most elements reserved up front.
+    };
+
+    bool _value( const char* data, size_t len )
+    {
+        if ( 1 == _depth || ( 2 == _depth && _inPair ) )
+        {
+            _element( data, len );
+        }
+        return true;
+    }
+
+    void _element( const char* data, size_t len )
+    {
+        ++_count;
+        if ( NULL != _pValues )
+        {
+            _pValues->push_back( std::string( data, len ) );
+        }else if ( !_hasKey )
+        {
+            _key.assign( data, len );
+            _hasKey = true;
+        }else
+        {
+            _pPairs->push_back( std::tuple<std::string,std::string>( std::move( _key ), std::string( data, len ) ) );
+            _hasKey = false;
+        }
+    }
+
+    VecString* _pValues;
+    TupleString* _pPairs;
+    int _depth;			///< arrays open, 1 while the elements of the reply are handed over.
+    uint64_t _count;		///< elements of the reply, a pair in an array counts as 2.
+    bool _isArray;
+    bool _isNil;
+    bool _hasKey;		///< _key is waiting for its value.
+    bool _inPair;		///< the elements of an array of 2 at depth 1 are handed over.
+    std::string _key;
+    std::string _error;
+};
+
+#endif // CSTRINGSHANDLER_H
@@ -0,0 +1,76 @@
+/**
+ * @file	CmdHeader.h
+ * @brief 参数个数固定的 redis 指令，其 "*argc\r\n$len\r\nNAME\r\n" 前缀在编译期生成。
+ *
+ * Command cmd( CMD_GET ); cmd << key;
+ * 只有 key 需要在运行时编码。
+ */
+
+#ifndef CMDHEADER_H
+#define CMDHEADER_H
+
+#include <stddef.h>
+
+/**
+ * @brief The CmdHeader struct is the encoded prefix of a command with a fixed number of params.
+ */
+struct CmdHeader
+{
+    const char* data;	///< "*argc\r\n$len\r\nNAME\r\n"
+    size_t len;			///< length of data
+    const char* name;	///< name of the command
+    size_t argc;		///< number of params, the name included
+};
+
+///< Define a CmdHeader in static storage, len must be the length of name.
+#define REDIS_FIXED_COMMAND( var, argc, len, name ) \
+    static_assert( sizeof( name ) - 1 == len, "length of " name " is not " #len ); \
+    constexpr CmdHeader var = { "*" #argc "\r\n$" #len "\r\n" name "\r\n", \
+                                sizeof( "*" #argc "\r\n$" #len "\r\n" name "\r\n" ) - 1, name, argc }
+
+//---------------------------------connection----------------------------------------
+REDIS_FIXED_COMMAND( CMD_PING, 1, 4, "PING" );
+//-----------------------------------key---------------------------------------------
+REDIS_FIXED_COMMAND( CMD_EXISTS, 2, 6, "EXISTS" );
+REDIS_FIXED_COMMAND( CMD_EXPIRE, 3, 6, "EXPIRE" );
+REDIS_FIXED_COMMAND( CMD_PEXPIRE, 3, 7, "PEXPIRE" );
+REDIS_FIXED_COMMAND( CMD_TTL, 2, 3, "TTL" );
+REDIS_FIXED_COMMAND( CMD_PTTL, 2, 4, "PTTL" );
+REDIS_FIXED_COMMAND( CMD_PERSIST, 2, 7, "PERSIST" );
+REDIS_FIXED_COMMAND( CMD_TYPE, 2, 4, "TYPE" );
+//-----------------------------string method--------------------------------------
+REDIS_FIXED_COMMAND( CMD_GET, 2, 3, "GET" );
+REDIS_FIXED_COMMAND( CMD_SET, 3, 3, "SET" );
+REDIS_FIXED_COMMAND( CMD_GETSET, 3, 6, "GETSET" );
+REDIS_FIXED_COMMAND( CMD_APPEND, 3, 6, "APPEND" );
+REDIS_FIXED_COMMAND( CMD_STRLEN, 2, 6, "STRLEN" );
+REDIS_FIXED_COMMAND( CMD_INCR, 2, 4, "INCR" );
+REDIS_FIXED_COMMAND( CMD_INCRBY, 3, 6, "INCRBY" );
+REDIS_FIXED_COMMAND( CMD_INCRBYFLOAT, 3, 11, "INCRBYFLOAT" );
+REDIS_FIXED_COMMAND( CMD_DECR, 2, 4, "DECR" );
+REDIS_FIXED_COMMAND( CMD_DECRBY, 3, 6, "DECRBY" );
+//-----------------------------------hash--------------------------------------------
+REDIS_FIXED_COMMAND( CMD_HGET, 3, 4, "HGET" );
+REDIS_FIXED_COMMAND( CMD_HSET, 4, 4, "HSET" );
+REDIS_FIXED_COMMAND( CMD_HSETNX, 4, 6, "HSETNX" );
+REDIS_FIXED_COMMAND( CMD_HEXISTS, 3, 7, "HEXISTS" );
+REDIS_FIXED_COMMAND( CMD_HGETALL, 2, 7, "HGETALL" );
+REDIS_FIXED_COMMAND( CMD_HINCRBY, 4, 7, "HINCRBY" );
+REDIS_FIXED_COMMAND( CMD_HINCRBYFLOAT, 4, 12, "HINCRBYFLOAT" );
+REDIS_FIXED_COMMAND( CMD_HLEN, 2, 4, "HLEN" );
+//-----------------------------------list--------------------------------------------
+REDIS_FIXED_COMMAND( CMD_LPOP, 2, 4, "LPOP" );
+REDIS_FIXED_COMMAND( CMD_RPOP, 2, 4, "RPOP" );
+REDIS_FIXED_COMMAND( CMD_LLEN, 2, 4, "LLEN" );
+REDIS_FIXED_COMMAND( CMD_LINDEX, 3, 6, "LINDEX" );
+//-----------------------------------set---------------------------------------------
+REDIS_FIXED_COMMAND( CMD_SCARD, 2, 5, "SCARD" );
+REDIS_FIXED_COMMAND( CMD_SISMEMBER, 3, 9, "SISMEMBER" );
+REDIS_FIXED_COMMAND( CMD_SMEMBERS, 2, 8, "SMEMBERS" );
+//--------------------------------sorted set-----------------------------------------
+REDIS_FIXED_COMMAND( CMD_ZCARD, 2, 5, "ZCARD" );
+REDIS_FIXED_COMMAND( CMD_ZRANK, 3, 5, "ZRANK" );
+REDIS_FIXED_COMMAND( CMD_ZSCORE, 3, 6, "ZSCORE" );
+REDIS_FIXED_COMMAND( CMD_ZINCRBY, 4, 7, "ZINCRBY" );
+
+#endif // CMDHEADER_H
@@ -14,5 +14,48 @@ const char* Command::_CRLF = "\r\n";	///< 一行的结束标志
 
 string Command::getCommand()
 {
-    return ( *_param.begin() );
+    return _name;
+}
+
+const char* Command::_formatHead( char prefix, size_t len, char* end )
+{
+    char* p = end;
+    *--p = '\n';
+    *--p = '\r';
+    do
+    {
+        *--p = static_cast<char>( '0' + len % 10 );
+        len /= 10;
+    }while ( len != 0 );
+    *--p = prefix;
+    return p;
+}
+
+void Command::_appendHead( char prefix, size_t len )
+{
+    char tmp[32];
+    const char* p = _formatHead( prefix, len, tmp + sizeof( tmp ) );
+    _appendOwned( p, tmp + sizeof( tmp ) - p );
+}
+
+void Command::_makeHead( void )
+{
+    if ( NULL != _fixed && _argc == _fixed->argc )
+    {
+        _pHead = _fixed->data;
+        _headLen = _fixed->len;
+        return;
+    }
+
+    char tmp[32];
+    const char* p = _formatHead( '*', _argc, tmp + sizeof( tmp ) );
+    _head.assign( p, tmp + sizeof( tmp ) - p );
+    if ( NULL != _fixed )
+    {
+        // params were added beyond the fixed arity, keep the encoded name only.
+        const char* pName = static_cast<const char*>( memchr( _fixed->data, '\n', _fixed->len ) ) + 1;
+        _head.append( pName, _fixed->data + _fixed->len - pName );
+    }
+    _pHead = _head.data();
+    _headLen = _head.size();
 }
@@ -13,19 +13,70 @@
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <algorithm>
+#include <type_traits>
+#include <string.h>
+#include <sys/uio.h>
 #include <Poco/Types.h>
 #include "redisCommon.h"
+#include "RdNumeric.h"
+#include "CmdHeader.h"
 
 using std::stringstream;
 using std::vector;
 
 class Command
 {
+private:
+    ///< stringstream writes these as characters, not numbers.
+    template <typename T>
+    struct _IsChar
+    {
+        enum
+        {
+            value = std::is_same<T, char>::value || std::is_same<T, signed char>::value ||
+                    std::is_same<T, unsigned char>::value
+        };
+    };
+
 public:
+    /**
+     * @brief The Ref struct refers to a buffer owned by the caller, it is sent without being copied.
+     * @warning The buffer must stay alive and unchanged until the command is sent.
+     */
+    struct Ref
+    {
+        Ref( const char* data, size_t len ):
+            data( data ),
+            len( len )
+        {
+        }
+
+        explicit Ref( const string& value ):
+            data( value.data() ),
+            len( value.size() )
+        {
+        }
+
+        const char* data;
+        size_t len;
+    };
+
+    typedef std::vector<struct iovec> VecIovec;
+
    explicit Command( const string& cmd )
     {
-        _make = false;
-        _param.push_back( cmd );
+        reset( cmd );
+    }
+
+    /**
+     * @brief Command the name and "*argc" come from a prefix encoded at compile time,
+     * only params are encoded at runtime. eg: Command cmd( CMD_GET ); cmd << key;
+     * @param header [in] see CmdHeader.h
+     */
+    explicit Command( const CmdHeader& header )
+    {
+        reset( header );
     }
     ~Command()
     {
@@ -37,28 +88,166 @@ public:
     * @param param
     */
     template <typename T>
-    inline Command& operator<<( const T& param )
+    inline typename std::enable_if<!std::is_arithmetic<T>::value, Command&>::type
+    operator<<( const T& param )
     {
         std::stringstream str ;
         str << param;
-        _param.push_back( str.str() );
+        const string& value = str.str();
+        _addArg( value.data(), value.size() );
+        return *this;
+    }
+
+    /**
+    * @brief operator <<     add an integer param, formatted without stringstream.
+    */
+    template <typename T>
+    inline typename std::enable_if<std::is_integral<T>::value && !_IsChar<T>::value, Command&>::type
+    operator<<( T param )
+    {
+        char tmp[RdNumeric::MAX_INT_SIZE];
+        size_t len = std::is_signed<T>::value ?
+                    RdNumeric::formatInt( static_cast<int64_t>( param ), tmp ) :
+                    RdNumeric::formatUInt( static_cast<uint64_t>( param ), tmp );
+        _addArg( tmp, len );
+        return *this;
+    }
+
+    /**
+    * @brief operator <<     add a character param, like stringstream does.
+    */
+    template <typename T>
+    inline typename std::enable_if<_IsChar<T>::value, Command&>::type
+    operator<<( T param )
+    {
+        char ch = static_cast<char>( param );
+        _addArg( &ch, 1 );
+        return *this;
+    }
+
+    inline Command& operator<<( float param )
+    {
+        char tmp[RdNumeric::MAX_DOUBLE_SIZE];
+        _addArg( tmp, RdNumeric::formatFloat( param, tmp ) );
+        return *this;
+    }
+
+    inline Command& operator<<( double param )
+    {
+        char tmp[RdNumeric::MAX_DOUBLE_SIZE];
+        _addArg( tmp, RdNumeric::formatDouble( param, tmp ) );
+        return *this;
+    }
+
+    inline Command& operator<<( const string& param )
+    {
+        _addArg( param.data(), param.size() );
+        return *this;
+    }
+
+    inline Command& operator<<( const char* param )
+    {
+        _addArg( param, strlen( param ) );
+        return *this;
+    }
+
+    /**
+    * @brief operator <<     add a param refers to the caller's buffer.
+    * Small buffers are copied anyway, an extra iovec costs more than copying them.
+    */
+    inline Command& operator<<( const Ref& param )
+    {
+        if ( param.len < MIN_REF_SIZE )
+        {
+            _addArg( param.data, param.len );
+            return *this;
+        }
+
+        _make = false;
+        ++_argc;
+        _appendHead( '$', param.len );
+        _segments.push_back( Segment( param.data, 0, param.len ) );
+        _appendOwned( _CRLF, 2 );
         return *this;
     }
 
+    /**
+     * @brief reset start a new command, the memory already allocated is reused.
+     * @param cmd [in] name of the new command.
+     */
+    void reset( const string& cmd )
+    {
+        _make = false;
+        _fixed = NULL;
+        _argc = 0;
+        _name = cmd;
+        _buffer.clear();
+        _segments.clear();
+        _addArg( cmd.data(), cmd.size() );
+    }
+
+    void reset( const CmdHeader& header )
+    {
+        _make = false;
+        _fixed = &header;
+        _argc = 1;
+        _name = header.name;
+        _buffer.clear();
+        _segments.clear();
+    }
+
+    /**
+     * @brief reserve make room for params of bytes encoded, so adding them does not reallocate.
+     */
+    void reserve( size_t bytes )
+    {
+        _buffer.reserve( _buffer.size() + bytes );
+    }
+
     void makeCommand( void )
     {
         if ( _make )
         {
             return;
         }
-        _dataString.str("");
-        size_t size = _param.size();
-        _dataString << '*' << size << _CRLF;
-        vector<string>::const_iterator it = _param.begin();
-        for ( ; it != _param.end(); ++it )
+        _makeHead();
+
+        size_t total = _headLen;
+        vector<Segment>::const_iterator it = _segments.begin();
+        for ( ; it != _segments.end(); ++it )
+        {
+            total += it->len;
+        }
+
+        _dataString.clear();
+        _dataString.reserve( total );
+        _dataString.assign( _pHead, _headLen );
+        for ( it = _segments.begin(); it != _segments.end(); ++it )
+        {
+            _dataString.append( _segmentData( *it ), it->len );
+        }
+        _make = true;
+    }
+
+    /**
+     * @brief makeIovec describe the encoded command as a list of buffers for writev()/sendmsg().
+     * @param iov [out] buffers are appended to it. They are valid as long as the command
+     * is not changed.
+     */
+    void makeIovec( VecIovec& iov )
+    {
+        _makeHead();
+        struct iovec vec;
+        vec.iov_base = const_cast<char*>( _pHead );
+        vec.iov_len = _headLen;
+        iov.push_back( vec );
+
+        vector<Segment>::const_iterator it = _segments.begin();
+        for ( ; it != _segments.end(); ++it )
         {
-            _dataString << '$' << it->size() << _CRLF;
-            _dataString << *it << _CRLF;
+            vec.iov_base = const_cast<char*>( _segmentData( *it ) );
+            vec.iov_len = it->len;
+            iov.push_back( vec );
         }
     }
 
@@ -68,25 +257,97 @@ public:
     operator string(  )
     {
         makeCommand();
-        return _dataString.str();
+        return _dataString;
     }
 
     size_t getLength( void )
     {
         makeCommand();
-        return _dataString.str().length();
+        return _dataString.length();
     }
 
     const char* getData( void )
     {
         makeCommand();
-        return _dataString.str().data();
+        return _dataString.data();
     }
 
     string getCommand( void );
 private:
-    std::stringstream _dataString;		///< 实现各种类型与 string 的互转。
-    std::vector<string> _param;			///< 存放一次交互的参数个数
+    enum
+    {
+        MIN_REF_SIZE = 4096		///< Ref smaller than this is copied.
+    };
+
+    ///< A piece of the encoded command, either in _buffer at offset or in a caller's buffer.
+    struct Segment
+    {
+        Segment( const char* ref, size_t offset, size_t len ):
+            ref( ref ),
+            offset( offset ),
+            len( len )
+        {
+        }
+
+        const char* ref;
+        size_t offset;
+        size_t len;
+    };
+
+    void _addArg( const char* data, size_t len )
+    {
+        _make = false;
+        ++_argc;
+
+        // "$<len>\r\n<data>\r\n", grow the buffer at most once for it.
+        size_t need = _buffer.size() + RdNumeric::uintLength( len ) + len + 5;
+        if ( need > _buffer.capacity() )
+        {
+            _buffer.reserve( std::max( need, _buffer.capacity() * 2 ) );
+        }
+        _appendHead( '$', len );
+        _appendOwned( data, len );
+        _appendOwned( _CRLF, 2 );
+    }
+
+    /**
+     * @brief _formatHead format "<prefix><len>\r\n" backwards from end.
+     * @return where the formatted text begins.
+     */
+    static const char* _formatHead( char prefix, size_t len, char* end );
+
+    void _appendHead( char prefix, size_t len );
+
+    void _appendOwned( const char* data, size_t len )
+    {
+        if ( _segments.empty() || NULL != _segments.back().ref )
+        {
+            _segments.push_back( Segment( NULL, _buffer.size(), 0 ) );
+        }
+        _buffer.append( data, len );
+        _segments.back().len += len;
+    }
+
+    const char* _segmentData( const Segment& seg ) const
+    {
+        return ( NULL != seg.ref ) ? seg.ref : _buffer.data() + seg.offset;
+    }
+
+    /**
+     * @brief _makeHead point _pHead to the prefix before the first segment: "*argc\r\n",
+     * or the whole CmdHeader if the number of params matches it.
+     */
+    void _makeHead( void );
+
+    string _dataString;		///< the whole encoded command.
+    string _name;					///< name of the command
+    string _head;					///< "*argc\r\n" encoded at runtime
+    const CmdHeader* _fixed;		///< prefix encoded at compile time, NULL if none.
+    const char* _pHead;			///< _head or _fixed->data
+    size_t _headLen;				///< length of _pHead
+    string _buffer;				///< encoded bytes owned by the command.
+    vector<Segment> _segments;	///< the encoded command after _head, in order.
+    size_t _argc;					///< 存放一次交互的参数个数
     static const char* _CRLF;			///< 一行的结束标志
     bool _make;									///< 标记是否已经 makeCommand
 };
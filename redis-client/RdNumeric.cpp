@@ -0,0 +1,234 @@
+/**
+ *
+ * @file	RdNumeric.cpp
+ * @brief 数值与 redis 协议文本之间的转换，不经过 stringstream。
+ *
+ */
+
+#include "RdNumeric.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <locale.h>
+#include <string>
+
+static const char DIGITS_LUT[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+size_t RdNumeric::uintLength( uint64_t value )
+{
+    size_t len = 1;
+    for ( ;; )
+    {
+        if ( value < 10ULL ) return len;
+        if ( value < 100ULL ) return len + 1;
+        if ( value < 1000ULL ) return len + 2;
+        if ( value < 10000ULL ) return len + 3;
+        value /= 10000ULL;
+        len += 4;
+    }
+}
+
+size_t RdNumeric::formatUInt( uint64_t value, char* buf )
+{
+    size_t len = uintLength( value );
+    char* p = buf + len;
+
+    // two digits per division.
+    while ( value >= 100 )
+    {
+        unsigned idx = static_cast<unsigned>( value % 100 ) * 2;
+        value /= 100;
+        *--p = DIGITS_LUT[idx + 1];
+        *--p = DIGITS_LUT[idx];
+    }
+    if ( value >= 10 )
+    {
+        unsigned idx = static_cast<unsigned>( value ) * 2;
+        *--p = DIGITS_LUT[idx + 1];
+        *--p = DIGITS_LUT[idx];
+    }else
+    {
+        *--p = static_cast<char>( '0' + value );
+    }
+    return len;
+}
+
+size_t RdNumeric::formatInt( int64_t value, char* buf )
+{
+    if ( value < 0 )
+    {
+        *buf = '-';
+        // negate in unsigned, INT64_MIN has no positive counterpart.
+        return 1 + formatUInt( 0ULL - static_cast<uint64_t>( value ), buf + 1 );
+    }
+    return formatUInt( static_cast<uint64_t>( value ), buf );
+}
+
+/**
+ * @brief _cLocale redis always writes "1.5", whatever setlocale() the program called.
+ * @return the "C" locale, created once.
+ */
+static locale_t _cLocale( void )
+{
+    static const locale_t s_cLocale = newlocale( LC_ALL_MASK, "C", static_cast<locale_t>( 0 ) );
+    return s_cLocale;
+}
+
+/**
+ * @brief The CLocaleScope class switches the calling thread to the "C" locale for snprintf(),
+ * which has no _l variant. Other threads are not affected.
+ */
+class CLocaleScope
+{
+public:
+    CLocaleScope(): _old( uselocale( _cLocale() ) ) {}
+    ~CLocaleScope() { uselocale( _old ); }
+
+private:
+    locale_t _old;
+};
+
+static double _strtod( const char* text, char** end )
+{
+    return strtod_l( text, end, _cLocale() );
+}
+
+static float _strtof( const char* text, char** end )
+{
+    return strtof_l( text, end, _cLocale() );
+}
+
+size_t RdNumeric::formatDouble( double value, char* buf )
+{
+    CLocaleScope scope;
+    char tmp[MAX_DOUBLE_SIZE + 8];
+    int len = snprintf( tmp, sizeof( tmp ), "%.15g", value );
+    if ( _strtod( tmp, NULL ) != value )
+    {
+        len = snprintf( tmp, sizeof( tmp ), "%.17g", value );
+    }
+    memcpy( buf, tmp, len );
+    return len;
+}
+
+size_t RdNumeric::formatFloat( float value, char* buf )
+{
+    CLocaleScope scope;
+    char tmp[MAX_DOUBLE_SIZE + 8];
+    int len = snprintf( tmp, sizeof( tmp ), "%.6g", value );
+    if ( _strtof( tmp, NULL ) != value )
+    {
+        len = snprintf( tmp, sizeof( tmp ), "%.9g", value );
+    }
+    memcpy( buf, tmp, len );
+    return len;
+}
+
+bool RdNumeric::parseUInt( const char* data, size_t len, uint64_t& value )
+{
+    if ( 0 == len || len > 20 )
+    {
+        return false;
+    }
+
+    uint64_t result = 0;
+    for ( size_t i = 0; i < len; ++i )
+    {
+        unsigned digit = static_cast<unsigned char>( data[i] ) - '0';
+        if ( digit > 9 )
+        {
+            return false;
+        }
+        // only the 20th digit can overflow.
+        if ( result > ( UINT64_MAX - digit ) / 10 )
+        {
+            return false;
+        }
+        result = result * 10 + digit;
+    }
+    value = result;
+    return true;
+}
+
+bool RdNumeric::parseInt( const char* data, size_t len, int64_t& value )
+{
+    bool negative = ( len > 0 && '-' == data[0] );
+    uint64_t abs = 0;
+    if ( !parseUInt( data + negative, len - negative, abs ) )
+    {
+        return false;
+    }
+
+    if ( negative )
+    {
+        if ( abs > static_cast<uint64_t>( INT64_MAX ) + 1 )
+        {
+            return false;
+        }
+        value = static_cast<int64_t>( 0ULL - abs );
+    }else
+    {
+        if ( abs > static_cast<uint64_t>( INT64_MAX ) )
+        {
+            return false;
+        }
+        value = static_cast<int64_t>( abs );
+    }
+    return true;
+}
+
+/**
+ * @brief _parseReal strtod() needs a null terminated string, copy data to the stack
+ * when it is short, which is the case for any double written by redis.
+ */
+template <typename T, typename F>
+static bool _parseReal( const char* data, size_t len, T& value, F convert )
+{
+    if ( 0 == len || isspace( static_cast<unsigned char>( data[0] ) ) )
+    {
+        return false;
+    }
+
+    char tmp[RdNumeric::MAX_DOUBLE_SIZE * 2];
+    std::string longText;
+    const char* text = tmp;
+    if ( len < sizeof( tmp ) )
+    {
+        memcpy( tmp, data, len );
+        tmp[len] = '\0';
+    }else
+    {
+        longText.assign( data, len );
+        text = longText.c_str();
+    }
+
+    char* end = NULL;
+    T result = convert( text, &end );
+    if ( end != text + len )
+    {
+        return false;
+    }
+    value = result;
+    return true;
+}
+
+bool RdNumeric::parseDouble( const char* data, size_t len, double& value )
+{
+    return _parseReal( data, len, value, _strtod );
+}
+
+bool RdNumeric::parseFloat( const char* data, size_t len, float& value )
+{
+    return _parseReal( data, len, value, _strtof );
+}
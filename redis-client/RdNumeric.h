@@ -0,0 +1,75 @@
+/**
+ *
+ * @file	RdNumeric.h
+ * @brief 数值与 redis 协议文本之间的转换，不经过 stringstream。
+ *
+ */
+
+#ifndef RDNUMERIC_H
+#define RDNUMERIC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+class RdNumeric
+{
+public:
+    enum
+    {
+        MAX_INT_SIZE    = 24,	///< enough for any int64_t/uint64_t.
+        MAX_DOUBLE_SIZE = 32	///< enough for any double in "%.17g".
+    };
+
+    /**
+     * @brief formatInt write value in decimal.
+     * @param value [in]
+     * @param buf [out] at least MAX_INT_SIZE bytes, not null terminated.
+     * @return the number of bytes written.
+     */
+    static size_t formatInt( int64_t value, char* buf );
+    static size_t formatUInt( uint64_t value, char* buf );
+
+    /**
+     * @brief formatDouble write the shortest text that reads back as the same value.
+     * It always uses '.', whatever the locale of the program.
+     * @param value [in]
+     * @param buf [out] at least MAX_DOUBLE_SIZE bytes, not null terminated.
+     * @return the number of bytes written.
+     */
+    static size_t formatDouble( double value, char* buf );
+    static size_t formatFloat( float value, char* buf );
+
+    /**
+     * @brief parseInt parse a decimal integer strictly: an optional '-', then digits only,
+     * no spaces, no trailing bytes, no overflow.
+     * @param data [in] text, not null terminated.
+     * @param len [in] length of data.
+     * @param value [out]
+     * @return false: data is not a valid integer, value is unchanged.
+     */
+    static bool parseInt( const char* data, size_t len, int64_t& value );
+    static bool parseUInt( const char* data, size_t len, uint64_t& value );
+
+    /**
+     * @brief parseDouble parse a double the way redis writes it, "inf" and "-inf" included.
+     * '.' is the decimal point, whatever the locale of the program.
+     * The whole of data must be used and it may not start with spaces.
+     * @return false: data is not a valid double, value is unchanged.
+     */
+    static bool parseDouble( const char* data, size_t len, double& value );
+    static bool parseFloat( const char* data, size_t len, float& value );
+
+    ///< overloads for templates, eg: CRedisClient::_valueFromString<T>.
+    static bool parse( const char* data, size_t len, int64_t& value ) { return parseInt( data, len, value ); }
+    static bool parse( const char* data, size_t len, uint64_t& value ) { return parseUInt( data, len, value ); }
+    static bool parse( const char* data, size_t len, double& value ) { return parseDouble( data, len, value ); }
+    static bool parse( const char* data, size_t len, float& value ) { return parseFloat( data, len, value ); }
+
+    /**
+     * @brief uintLength
+     * @return the number of decimal digits of value.
+     */
+    static size_t uintLength( uint64_t value );
+};
+
+#endif // RDNUMERIC_H
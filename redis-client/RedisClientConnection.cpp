@@ -19,7 +19,7 @@ bool CRedisClient::ping( string &value )
 {
     try
     {
-        Command cmd("PING");
+        Command cmd( CMD_PING );
         _getStatus(cmd, value);
         return true;
     }catch( ... )
@@ -28,6 +28,21 @@ bool CRedisClient::ping( string &value )
     }
 }
 
+void CRedisClient::hello( CResult &result, int protover )
+{
+    if ( 0 != _unreadReplies )
+    {
+        reconnect();
+    }
+    _hello( result, protover );
+    _protover = protover;
+}
+
+int CRedisClient::getProtocol( void ) const
+{
+    return _protover;
+}
+
 void CRedisClient::quit( )
 {
 	Command cmd("QUIT");
@@ -48,6 +63,7 @@ void CRedisClient::auth( const string &password )
 	cmd << password;
 	string value;
     _getStatus(cmd, value);
+    _password = password;
 }
 
 void CRedisClient::select( uint64_t index )
@@ -56,6 +72,7 @@ void CRedisClient::select( uint64_t index )
 	cmd << index;
 	string value;
     _getStatus(cmd, value);
+    _dbIndex = index;
 }
 
 
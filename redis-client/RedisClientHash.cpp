@@ -17,8 +17,8 @@
 //------------------------------hash method-----------------------------------
 uint8_t CRedisClient::hset(const std::string &key, const std::string &field, const std::string &value)
 {
-   Command cmd( "HSET" );
-   cmd << key << field << value;
+   Command cmd( CMD_HSET );
+   cmd << key << field << Command::Ref( value );
    int64_t num = 0;
    _getInt( cmd , num );
    return num;
@@ -28,11 +28,22 @@ uint8_t CRedisClient::hset(const std::string &key, const std::string &field, con
 
 bool CRedisClient::hget( const std::string &key, const std::string &field, string &value )
 {
-    Command cmd( "HGET" );
+    Command cmd( CMD_HGET );
     cmd << key << field;
+    if ( _cacheUsable() )
+    {
+        return _getCached( cmd, key, &field, value );
+    }
     return _getString( cmd , value );
 }
 
+bool CRedisClient::hgetView( const string &key, const string &field, const ViewCallback &callback )
+{
+    Command cmd( CMD_HGET );
+    cmd << key << field;
+    return _getView( cmd, callback );
+}
+
 
 uint64_t CRedisClient::hdel( const string &key, const CRedisClient::VecString &fields )
 {
@@ -54,7 +65,7 @@ uint64_t CRedisClient::hdel( const string &key, const CRedisClient::VecString &f
 
 bool CRedisClient::hexists(const string &key, const string &field)
 {
-    Command cmd( "HEXISTS" );
+    Command cmd( CMD_HEXISTS );
     cmd << key << field;
     int64_t num = 0;
     _getInt( cmd, num );
@@ -64,7 +75,7 @@ bool CRedisClient::hexists(const string &key, const string &field)
 
 uint64_t CRedisClient::hgetall(const string &key, CRedisClient::TupleString &pairs)
 {
-    Command cmd( "HGETALL" );
+    Command cmd( CMD_HGETALL );
     cmd << key;
 
     uint64_t num = 0;
@@ -72,10 +83,17 @@ uint64_t CRedisClient::hgetall(const string &key, CRedisClient::TupleString &pai
     return num;
 }
 
+bool CRedisClient::hgetall( const string &key, CRedisReplyHandler &handler )
+{
+    Command cmd( CMD_HGETALL );
+    cmd << key;
+    return _streamReply( cmd, handler );
+}
+
 
 int64_t CRedisClient::hincrby(const string &key, const string &field, int64_t increment)
 {
-    Command cmd( "HINCRBY" );
+    Command cmd( CMD_HINCRBY );
     cmd << key << field << increment;
 
     int64_t num = 0;
@@ -86,7 +104,7 @@ int64_t CRedisClient::hincrby(const string &key, const string &field, int64_t in
 
 double CRedisClient::hincrbyfloat(const string &key, const string &field, float increment)
 {
-    Command cmd( "HINCRBYFLOAT" );
+    Command cmd( CMD_HINCRBYFLOAT );
     cmd << key << field << increment;
     string value;
     _getString( cmd , value );
@@ -108,7 +126,7 @@ uint64_t CRedisClient::hkeys(const string &key, CRedisClient::VecString &values)
 
 uint64_t CRedisClient::hlen(const string &key)
 {
-   Command cmd( "HLEN" );
+   Command cmd( CMD_HLEN );
    cmd << key;
    int64_t num = 0;
   _getInt( cmd, num );
@@ -127,6 +145,11 @@ void CRedisClient::hmget(const string &key, const CRedisClient::VecString &field
         cmd << *it;
     }
 
+    if ( _cacheUsable() )
+    {
+        _getCached( cmd, key, fields, result );
+        return;
+    }
     _getArry( cmd , result );
 }
 
@@ -140,7 +163,7 @@ void CRedisClient::hmset(const string &key, const CRedisClient::TupleString &pai
     for ( ; it !=end ; ++it )
     {
         cmd << std::get<0>(*it);
-        cmd << std::get<1>(*it);
+        cmd << Command::Ref( std::get<1>(*it) );
     }
     string status;
     _getStatus( cmd, status );
@@ -149,8 +172,8 @@ void CRedisClient::hmset(const string &key, const CRedisClient::TupleString &pai
 
 bool CRedisClient::hsetnx(const string &key, const string &field, const string &value)
 {
-    Command cmd( "HSETNX" );
-    cmd << key << field << value;
+    Command cmd( CMD_HSETNX );
+    cmd << key << field << Command::Ref( value );
     int64_t num = 0;
     _getInt( cmd, num );
     return ( num==1 ? true:false );
@@ -184,10 +207,10 @@ bool CRedisClient::hscan(const string &key, int64_t &cursor, TupleString &values
         cmd << "COUNT" << count;
     }
     _getArry( cmd, result );
-    CResult::ListCResult::const_iterator it = result.getArry().begin();
+    CResult::ListCResult::iterator it = result.getArry().begin();
     cursor = _valueFromString<uint64_t>( it->getString() );
     ++ it;
-    _getStringTupleFromArry( it->getArry(), values );
+    _getStringTupleFromArry( std::move( it->getArry() ), values );
     return ( cursor == 0 ? false : true );
 }
 
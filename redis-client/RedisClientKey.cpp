@@ -41,7 +41,7 @@ int64_t CRedisClient::del(const CRedisClient::VecString &keys )
 
 bool CRedisClient::exists( const string& key )
 {
-	Command cmd("EXISTS");
+	Command cmd( CMD_EXISTS );
 	cmd << key;
 	int64_t num = 0;
 	_getInt(cmd, num);
@@ -69,7 +69,7 @@ bool CRedisClient::pExpireAt( const string& key , const uint64_t& timestamp )
 
 bool CRedisClient::expire( const string& key , const uint64_t& seconds )
 {
-	Command cmd("EXPIRE");
+	Command cmd( CMD_EXPIRE );
 	cmd << key << seconds;
 	int64_t num = 0;
 	_getInt(cmd, num);
@@ -78,7 +78,7 @@ bool CRedisClient::expire( const string& key , const uint64_t& seconds )
 
 bool CRedisClient::pExpire( const string& key , const uint64_t& msec )
 {
-	Command cmd("PEXPIRE");
+	Command cmd( CMD_PEXPIRE );
 	cmd << key << msec;
 	int64_t num = 0;
 	_getInt(cmd, num);
@@ -87,7 +87,7 @@ bool CRedisClient::pExpire( const string& key , const uint64_t& msec )
 
 int64_t CRedisClient::ttl( const string& key )
 {
-	Command cmd("TTL");
+	Command cmd( CMD_TTL );
 	cmd << key;
 	int64_t num = 0;
 	_getInt(cmd, num);
@@ -96,7 +96,7 @@ int64_t CRedisClient::ttl( const string& key )
 
 int64_t CRedisClient::pttl( const string& key )
 {
-	Command cmd("PTTL");
+	Command cmd( CMD_PTTL );
 	cmd << key;
 	int64_t num = 0;
 	_getInt(cmd, num);
@@ -105,7 +105,7 @@ int64_t CRedisClient::pttl( const string& key )
 
 bool CRedisClient::persist( const string& key )
 {
-	Command cmd("PERSIST");
+	Command cmd( CMD_PERSIST );
 	cmd << key;
 	int64_t num = 0;
 	_getInt(cmd, num);
@@ -240,7 +240,7 @@ uint64_t CRedisClient::sort(const string& key , const string& storeKey, int64_t
 
 REDIS_DATA_TYPE CRedisClient::type( const string& key )
 {
-	Command cmd("TYPE");
+	Command cmd( CMD_TYPE );
 	cmd << key;
 
     string type;
@@ -298,10 +298,10 @@ bool CRedisClient::scan( int64_t cursor,VecString &values, const string &match,
     }
 
     _getArry( cmd, result );
-    CResult::ListCResult::const_iterator it = result.getArry().begin();
+    CResult::ListCResult::iterator it = result.getArry().begin();
    lastCur = _valueFromString<uint64_t>( it->getString() );
    ++it;
-   _getStringVecFromArry( it->getArry(), values );
+   _getStringVecFromArry( std::move( it->getArry() ), values );
    return ( lastCur == 0 ? false : true );
 }
 
@@ -317,7 +317,7 @@ bool CRedisClient::restore(const string& key , const string& buf , const int ttl
 	Command cmd("RESTORE");
 	string status;
 
-    cmd << key << ttl << buf;
+    cmd << key << ttl << Command::Ref( buf );
 
     return _getStatus(cmd, status);
 }
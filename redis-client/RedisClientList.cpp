@@ -20,7 +20,7 @@ uint64_t CRedisClient::lpush( const string &key , const VecString &value )
 	VecString::const_iterator end = value.end();
 	for ( ; it != end ; ++it )
 	{
-		cmd << *it;
+		cmd << Command::Ref( *it );
 	}
 
 	int64_t num = 0;
@@ -37,7 +37,7 @@ uint64_t CRedisClient::rpush( const string &key , const VecString &value )
 	VecString::const_iterator end = value.end();
 	for ( ; it != end ; ++it )
 	{
-		cmd << *it;
+		cmd << Command::Ref( *it );
 	}
 
 	int64_t num = 0;
@@ -49,7 +49,7 @@ uint64_t CRedisClient::rpushx( const string& key , const string& value )
 {
 	Command cmd("RPUSHX");
 	cmd << key;
-	cmd << value;
+	cmd << Command::Ref( value );
 
 	int64_t num = 0;
 	_getInt(cmd, num);
@@ -60,7 +60,7 @@ uint64_t CRedisClient::lpushx( const string& key , const string& value )
 {
 	Command cmd("LPUSHX");
 	cmd << key;
-	cmd << value;
+	cmd << Command::Ref( value );
 
 	int64_t num = 0;
 	_getInt(cmd, num);
@@ -69,15 +69,22 @@ uint64_t CRedisClient::lpushx( const string& key , const string& value )
 
 bool CRedisClient::lpop( const string &key , std::string &value )
 {
-	Command cmd("LPOP");
+	Command cmd( CMD_LPOP );
 	cmd << key;
 
 	return _getString(cmd, value);
 }
 
+bool CRedisClient::lindexView( const string &key, int64_t index, const ViewCallback &callback )
+{
+	Command cmd( CMD_LINDEX );
+	cmd << key << index;
+	return _getView( cmd, callback );
+}
+
 bool CRedisClient::rpop( const string &key , std::string &value )
 {
-	Command cmd("RPOP");
+	Command cmd( CMD_RPOP );
 	cmd << key;
 
 	return _getString(cmd, value);
@@ -85,7 +92,7 @@ bool CRedisClient::rpop( const string &key , std::string &value )
 
 bool CRedisClient::lindex( const string &key ,int64_t index , std::string &value )
 {
-	Command cmd("LINDEX");
+	Command cmd( CMD_LINDEX );
 	cmd << key;
 	cmd << index;
 
@@ -94,7 +101,7 @@ bool CRedisClient::lindex( const string &key ,int64_t index , std::string &value
 
 uint64_t CRedisClient::llen( const string& key )
 {
-	Command cmd("LLEN");
+	Command cmd( CMD_LLEN );
 	cmd << key;
 
 	int64_t num = 0;
@@ -114,7 +121,7 @@ int64_t CRedisClient::linsert(const string& key , WHERE where , const string &pi
     {
         realWhere = "after";
     }
-    cmd << key << realWhere << pivot << value;
+    cmd << key << realWhere << pivot << Command::Ref( value );
 
 	int64_t num = 0;
 	_getInt(cmd, num);
@@ -148,7 +155,7 @@ void CRedisClient::ltrim( const string &key , int64_t start , int64_t stop )
 void CRedisClient::lset( const string &key ,int64_t index , const string &value )
 {
 	Command cmd("LSET");
-	cmd << key << index << value;
+	cmd << key << index << Command::Ref( value );
 
 	string status;
     _getStatus(cmd, status);
@@ -173,6 +180,13 @@ uint64_t CRedisClient::lrange( const string &key , int64_t start , int64_t stop
     return num;
 }
 
+bool CRedisClient::lrange( const string &key, int64_t start, int64_t stop, CRedisReplyHandler &handler )
+{
+	Command cmd("LRANGE");
+	cmd << key << start << stop;
+	return _streamReply( cmd, handler );
+}
+
 bool CRedisClient::blpop( const CRedisClient::VecString &key , uint64_t &timeout ,
 		CRedisClient::TupleString &value )
 {
@@ -9,6 +9,18 @@
 #include "Command.h"
 #include "CRedisClient.h"
 
+/**
+ * @brief The CPubSubScope class sets a flag while subscribe or unsubscribe reads its replies,
+ * they are pushed with RESP3 and must not be taken by the push callback.
+ */
+class CPubSubScope
+{
+public:
+	explicit CPubSubScope( bool& reading ): _reading( reading ) { _reading = true; }
+	~CPubSubScope() { _reading = false; }
+private:
+	bool& _reading;
+};
 
 
 
@@ -21,6 +33,7 @@
 		cmd << *it;
 	}
 	_socket.setReceiveTimeout(0);
+	CPubSubScope scope( _readingPubSub );
 	result.clear();
 	_getArry( cmd, result );
 	while(true)
@@ -93,8 +106,6 @@
 
  void CRedisClient::punsubscribe( CResult& result, const VecString& pattern )
  {
-	_socket.clearBuffer();
-
 	Command cmd( "PUNSUBSCRIBE" );
 	if ( pattern.size() != 0 )
 	{
@@ -104,9 +115,7 @@
 			cmd << *it ;
 		}
 	}
-	_sendCommand( cmd );
-
-	_getReply( result );
+	_unsubscribe( cmd, pattern.size(), result );
  }
 
 
@@ -119,6 +128,7 @@
 		cmd << *it ;
 	}
 	_socket.setReceiveTimeout(0);
+	CPubSubScope scope( _readingPubSub );
 	result.clear();
 	_getArry( cmd, result );
 	while(true)
@@ -131,8 +141,6 @@
 
  void CRedisClient::unsubscribe( CResult& result, const VecString& channel )
  {
-	_socket.clearBuffer();
-
 	Command cmd( "UNSUBSCRIBE" );
 	if ( channel.size() != 0 )
 	{
@@ -142,19 +150,53 @@
 			cmd << *it ;
 		}
 	}
-	_sendCommand( cmd );
-
-    _getResult( cmd, result );
+	_unsubscribe( cmd, channel.size(), result );
  }
 
 
+ void CRedisClient::_unsubscribe( Command& cmd, size_t num, CResult& result )
+ {
+	CPubSubScope scope( _readingPubSub );
+	_sendCommand( cmd );
+	// [ "unsubscribe", channel, subscriptions left ] for each channel or pattern given,
+	// with none given for each one subscribed, the last one leaves 0.
+	for ( size_t read = 0; ; )
+	{
+		result.clear();
+		_getReply( result );
 
+		if ( REDIS_REPLY_ERROR == result.getType() )
+		{
+			throw ReplyErr( result.getErrorString() );
+		}
+		const CResult::ListCResult& arry = result.getArry();
+		if ( !_isPubSubReply( arry ) )
+		{
+			// a message published before the server took the command, the reply is still expected.
+			++_unreadReplies;
+			continue;
+		}
+		if ( 3 != arry.size() )
+		{
+			throw ProtocolErr( cmd.getCommand() + ": data recved is not arry" );
+		}
+		++read;
+		if ( ( 0 != num && read >= num ) || ( 0 == num && 0 == arry[2].getInt() ) )
+		{
+			break;
+		}
+		// still expected, a timeout leaves the connection poisoned.
+		++_unreadReplies;
+	}
+ }
 
 
-
-
-
-
-
-
-
+ bool CRedisClient::_isPubSubReply( const CResult::ListCResult& arry )
+ {
+	if ( arry.empty() )
+	{
+		return false;
+	}
+	const CResult& kind = arry[0];
+	return "subscribe" == kind || "unsubscribe" == kind || "psubscribe" == kind || "punsubscribe" == kind;
+ }
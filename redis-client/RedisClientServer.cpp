@@ -59,7 +59,6 @@ void CRedisClient::clientList(CResult& result)
 {
     Command cmd( "CLIENT" );
     cmd<<"LIST";
-    _socket.clearBuffer();
     _sendCommand(cmd);
     _getReply(result);
 
@@ -75,6 +74,15 @@ uint64_t CRedisClient::clientList(CRedisClient::VecString & reply)
     return stringToVecString(str,reply);
 }
 
+int64_t CRedisClient::clientId( void )
+{
+    Command cmd( "CLIENT" );
+    cmd << "ID";
+    int64_t id = 0;
+    _getInt( cmd, id );
+    return id;
+}
+
 void CRedisClient::clientSetname(const string& connectionName)
 {
     Command cmd( "CLIENT" );
@@ -153,7 +161,6 @@ void CRedisClient::debugSegfault()
 {
     Command cmd( "DEBUG" );
     cmd<<"SEGFAULT";
-    _socket.clearBuffer();
     _sendCommand(cmd);
 }
 
@@ -197,7 +204,6 @@ uint64_t CRedisClient::lastsave()
 void CRedisClient::monitorStart( void )
 {
      Command cmd("MONITOR");
-    _socket.clearBuffer();
     _sendCommand(cmd);
 }
 bool CRedisClient::monitorRead(std::string &value, uint64_t timeout )
@@ -261,7 +267,6 @@ void CRedisClient::slaveof(const string& host,const UInt16 port)
 void CRedisClient::slowlog(const CRedisClient::VecString &subcommand, CResult &reply)
 {
     Command cmd( "SLOWLOG" );
-    _socket.clearBuffer();
     VecString::const_iterator it = subcommand.begin();
     VecString::const_iterator  end=subcommand.end();
     for ( ; it !=end; ++it )
@@ -23,7 +23,7 @@ uint64_t CRedisClient::sadd(const string &key, const CRedisClient::VecString &me
 
 uint64_t CRedisClient::scard(const string &key)
 {
-    Command cmd( "SCARD" );
+    Command cmd( CMD_SCARD );
     cmd << key;
     int64_t num;
     _getInt( cmd , num );
@@ -98,7 +98,7 @@ uint64_t CRedisClient::sinterstore( const string& destKey ,const CRedisClient::V
 
 bool CRedisClient::sismember(const string &key, const string &member)
 {
-    Command cmd( "SISMEMBER" );
+    Command cmd( CMD_SISMEMBER );
     cmd << key << member;
 
     int64_t num = 0;
@@ -108,7 +108,7 @@ bool CRedisClient::sismember(const string &key, const string &member)
 
 uint64_t CRedisClient::smembers( const string &key, CRedisClient::VecString &members )
 {
-    Command cmd( "SMEMBERS" );
+    Command cmd( CMD_SMEMBERS );
     cmd << key;
 
     uint64_t num = 0;
@@ -116,6 +116,13 @@ uint64_t CRedisClient::smembers( const string &key, CRedisClient::VecString &mem
     return num;
 }
 
+bool CRedisClient::smembers( const string &key, CRedisReplyHandler &handler )
+{
+    Command cmd( CMD_SMEMBERS );
+    cmd << key;
+    return _streamReply( cmd, handler );
+}
+
 bool CRedisClient::smove(const string &source, const string &dest, const string &member)
 {
     Command cmd( "SMOVE" );
@@ -214,10 +221,10 @@ bool CRedisClient::sscan(const string &key, int64_t &cursor, VecString &values,
         cmd << "COUNT" << count;
     }
     _getArry( cmd, result );
-    CResult::ListCResult::const_iterator it = result.getArry().begin();
+    CResult::ListCResult::iterator it = result.getArry().begin();
     cursor = _valueFromString<uint64_t>( it->getString() );
     ++ it;
-    _getStringVecFromArry( it->getArry(), values );
+    _getStringVecFromArry( std::move( it->getArry() ), values );
     return ( cursor == 0 ? false : true );
 
 }
@@ -22,7 +22,7 @@ uint64_t CRedisClient::zadd(const string &key, const CRedisClient::TupleString &
 
 uint64_t CRedisClient::zcard(const string& key)
 {
-    Command cmd( "ZCARD" );
+    Command cmd( CMD_ZCARD );
     cmd << key;
     int64_t num;
     _getInt(cmd,num);
@@ -45,7 +45,7 @@ uint64_t CRedisClient::zcount(const string& key,const string& min,const string&
 
 double CRedisClient::zincrby(const string& key,double increment,const string& member)
 {
-    Command cmd( "ZINCRBY" );
+    Command cmd( CMD_ZINCRBY );
     cmd << key << increment<< member;
     string str;
     _getString(cmd,str);
@@ -65,6 +65,17 @@ uint64_t CRedisClient::zrange(const string &key, const int64_t start, const int6
     _getArry(cmd,reply,num);
     return num;
 }
+
+bool CRedisClient::zrange( const string &key, int64_t start, int64_t stop, CRedisReplyHandler &handler, bool withScores )
+{
+    Command cmd( "ZRANGE" );
+    cmd << key << start << stop;
+    if ( withScores )
+    {
+        cmd << "WITHSCORES";
+    }
+    return _streamReply( cmd, handler );
+}
 uint64_t CRedisClient::zrangeWithscore(const string &key, const int64_t start, const int64_t stop, CRedisClient::TupleString &reply)
 {
     Command cmd( "ZRANGE" );
@@ -92,7 +103,6 @@ uint64_t CRedisClient::zrangebyscore(const string &key, const string &min, const
 
 uint64_t CRedisClient::zrangebyscoreWithscore(const string &key, const string &min, const string &max, CRedisClient::TupleString &reply,int64_t offset,int64_t count)
 {
-    _socket.clearBuffer();
     Command cmd( "ZRANGEBYSCORE" );
     cmd << key << min<< max;
     cmd<<"WITHSCORES";
@@ -107,7 +117,7 @@ uint64_t CRedisClient::zrangebyscoreWithscore(const string &key, const string &m
 
 bool CRedisClient::zrank(const string& key,const string& member,int64_t& reply)
 {
-    Command cmd( "ZRANK" );
+    Command cmd( CMD_ZRANK );
     cmd << key << member;
 
     return _getInt(cmd,reply);
@@ -220,7 +230,7 @@ bool CRedisClient::zrevrank(const string& key,const string& member,int64_t& repl
 
 bool CRedisClient::zscore(const string& key,const string& member,string& reply)
 {
-    Command cmd( "ZSCORE" );
+    Command cmd( CMD_ZSCORE );
     cmd << key <<  member;
     return _getString(cmd,reply);
 }
@@ -356,10 +366,10 @@ bool CRedisClient::zscan(const string &key, int64_t &cursor, TupleString &reply,
         cmd << "COUNT" << count;
     }
     _getArry( cmd, result );
-    CResult::ListCResult::const_iterator it = result.getArry().begin();
+    CResult::ListCResult::iterator it = result.getArry().begin();
     cursor = _valueFromString<uint64_t>( it->getString() );
     ++ it;
-    _getStringTupleFromArry( it->getArry(), reply );
+    _getStringTupleFromArry( std::move( it->getArry() ), reply );
     return ( cursor == 0 ? false : true );
 }
 
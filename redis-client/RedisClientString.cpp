@@ -15,8 +15,8 @@
 
 uint64_t CRedisClient::append( const string& key, const string& value )
 {
-	Command cmd( "APPEND" );
-	cmd << key << value;
+	Command cmd( CMD_APPEND );
+	cmd << key << Command::Ref( value );
 	int64_t num = 0;
 	_getInt( cmd, num );
 	return num;
@@ -50,7 +50,7 @@ uint64_t CRedisClient::bitop( const string& operation, const string& destkey, Ve
 
 int64_t CRedisClient::decr( const string& key )
 {
-	Command cmd( "DECR" );
+	Command cmd( CMD_DECR );
 	cmd << key;
 	int64_t num = 0;
 	_getInt( cmd, num );
@@ -62,7 +62,7 @@ int64_t CRedisClient::decr( const string& key )
 
 int64_t CRedisClient::decrby( const string& key, int64_t decrement )
 {
-	Command cmd( "DECRBY" );
+	Command cmd( CMD_DECRBY );
 	cmd << key << decrement;
 	int64_t num = 0;
 	_getInt( cmd, num );
@@ -72,11 +72,22 @@ int64_t CRedisClient::decrby( const string& key, int64_t decrement )
 
 bool CRedisClient::get( const std::string &key, std::string &value )
 {
-    Command cmd( "GET" );
+    Command cmd( CMD_GET );
     cmd << key;
+    if ( _cacheUsable() )
+    {
+        return _getCached( cmd, key, NULL, value );
+    }
     return _getString( cmd, value );
 }
 
+bool CRedisClient::getView( const string &key, const ViewCallback &callback )
+{
+    Command cmd( CMD_GET );
+    cmd << key;
+    return _getView( cmd, callback );
+}
+
 
 uint8_t CRedisClient::getbit( const string& key, uint32_t offset )
 {
@@ -102,15 +113,15 @@ bool CRedisClient::getrange( const string& key, int64_t start, int64_t end, stri
 bool CRedisClient::getset(const string& key, const string &value, string &oldvalue )
 {
 	oldvalue.clear();
-	Command cmd( "GETSET" );
-	cmd << key << value;
+	Command cmd( CMD_GETSET );
+	cmd << key << Command::Ref( value );
 	return _getString( cmd, oldvalue );
 }
 
 
 int64_t CRedisClient::incr( const string& key )
 {
-	Command cmd( "INCR" );
+	Command cmd( CMD_INCR );
 	cmd << key;
 	int64_t num = 0;
 	_getInt( cmd, num );
@@ -120,7 +131,7 @@ int64_t CRedisClient::incr( const string& key )
 
 int64_t CRedisClient::incrby( const string& key, int64_t increment )
 {
-	Command cmd( "INCRBY" );
+	Command cmd( CMD_INCRBY );
 	cmd << key << increment;
 	int64_t num = 0;
 	_getInt( cmd, num );
@@ -130,7 +141,7 @@ int64_t CRedisClient::incrby( const string& key, int64_t increment )
 
 bool CRedisClient::incrbyfloat( const string& key, float increment, float& value )
 {
-	Command cmd( "INCRBYFLOAT" );
+	Command cmd( CMD_INCRBYFLOAT );
 	cmd << key << increment;
 
 	string strVal;
@@ -163,7 +174,7 @@ void CRedisClient::mset( CRedisClient::TupleString &value )
 	for ( ; it != value.end(); ++it )
 	{
         cmd << std::get<0>(*it);
-        cmd << std::get<1>(*it);
+        cmd << Command::Ref( std::get<1>(*it) );
 	}
 
 	string status;
@@ -182,7 +193,7 @@ uint8_t CRedisClient::msetnx( CRedisClient::TupleString &value )
 	for ( ; it != value.end(); ++it )
 	{
         cmd << std::get<0>(*it);
-        cmd << std::get<1>(*it);
+        cmd << Command::Ref( std::get<1>(*it) );
 	}
 
 	int64_t num = 0;
@@ -199,10 +210,8 @@ uint8_t CRedisClient::msetnx( CRedisClient::TupleString &value )
 
 void CRedisClient::_set(const string &key, const string &value, CResult &result, const string& suffix , long time,const string suffix2 )
 {
-    _socket.clearBuffer();
-
-    Command cmd( "SET" );
-    cmd << key << value;
+    Command cmd( CMD_SET );
+    cmd << key << Command::Ref( value );
 
     if ( suffix != "" )
     {
@@ -211,9 +220,7 @@ void CRedisClient::_set(const string &key, const string &value, CResult &result,
 
     if ( time != 0 )
     {
-        std::stringstream ss;
-        ss << time ;
-        cmd << ss.str();
+        cmd << time;
     }
     if ( suffix2 != "" )
     {
@@ -374,7 +381,7 @@ uint8_t CRedisClient::setbit_( const string& key, uint32_t offset, const string&
 uint64_t CRedisClient::setrange( const string& key, uint32_t offset, const string& value )
 {
 	Command cmd( "SETRANGE" );
-	cmd << key << offset << value;
+	cmd << key << offset << Command::Ref( value );
 	int64_t num = 0;
 	_getInt( cmd, num );
 	return num;
@@ -383,7 +390,7 @@ uint64_t CRedisClient::setrange( const string& key, uint32_t offset, const strin
 
 uint64_t CRedisClient::strlen( const string& key )
 {
-	Command cmd( "STRLEN" );
+	Command cmd( CMD_STRLEN );
 	cmd << key;
 	int64_t num = 0;
 	_getInt( cmd, num );